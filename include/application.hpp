@@ -22,6 +22,7 @@
 #include <adwaita.h>
 #include <glib/gi18n.h>
 #include <string>
+#include "lv2_world.hpp"
 #include "pipe_manager.hpp"
 #include "preferences_window.hpp"
 #include "presets_manager.hpp"
@@ -19,7 +19,7 @@
 
 #pragma once
 
-#include <ebur128.h>
+#include "loudness_analyzer.hpp"
 #include "plugin_base.hpp"
 
 class AutoGain : public PluginBase {
@@ -53,6 +53,8 @@ class AutoGain : public PluginBase {
 
   auto get_latency_seconds() -> float override;
 
+  void set_loudness_sources(const std::vector<std::shared_ptr<LoudnessAnalyzer>>& sources);
+
   sigc::signal<void(const double,  // loudness
                     const double,  // gain
                     const double,  // momentary
@@ -70,25 +72,31 @@ class AutoGain : public PluginBase {
   double loudness = 0.0;
 
  private:
-  bool ebur128_ready = false;
+  bool analyzer_ready = false;
 
   uint old_rate = 0U;
 
-  double target = -23.0;  // target loudness level
-  double silence_threshold = -70.0;
   double internal_output_gain = 1.0;
 
-  Reference reference = Reference::geometric_mean_msi;
+  struct Parameters {
+    double target = -23.0;  // target loudness level
+
+    double silence_threshold = -70.0;
+
+    Reference reference = Reference::geometric_mean_msi;
+  };
 
-  std::vector<float> data;
+  ParameterSet<Parameters> parameters;
 
-  ebur128_state* ebur_state = nullptr;
+  LoudnessAnalyzer analyzer;
+
+  std::vector<std::shared_ptr<LoudnessAnalyzer>> loudness_sources;
 
   std::vector<std::thread> mythreads;
 
-  auto init_ebur128() -> bool;
+  auto init_analyzer() -> bool;
 
-  static auto parse_reference_key(const std::string& key) -> Reference;
+  void publish_parameters() override;
 
-  void set_maximum_history(const int& seconds);
+  static auto parse_reference_key(const std::string& key) -> Reference;
 };
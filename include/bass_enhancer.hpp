@@ -47,4 +47,5 @@ class BassEnhancer : public PluginBase {
   double harmonics_port_value = 0.0;
 
  private:
+  lv2::ControlPort harmonics_port;
 };
@@ -54,6 +54,10 @@ void set_x_data(Chart* self, const std::vector<double>& x);
 
 void set_y_data(Chart* self, const std::vector<double>& y);
 
+void set_y_data(Chart* self, const std::vector<std::vector<double>>& traces);
+
+void set_traces_colors(Chart* self, const std::vector<GdkRGBA>& colors);
+
 void set_background_color(Chart* self, GdkRGBA color);
 
 void set_color(Chart* self, GdkRGBA color);
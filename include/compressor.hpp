@@ -54,6 +54,8 @@ class Compressor : public PluginBase {
   float envelope_port_value = 0.0F;
 
  private:
+  lv2::ControlPort latency_port, reduction_port, sidechain_port, curve_port, envelope_port;
+
   uint latency_n_frames = 0U;
 
   std::vector<pw_proxy*> list_proxies;
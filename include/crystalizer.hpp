@@ -52,31 +52,30 @@ class Crystalizer : public PluginBase {
   bool n_samples_is_power_of_2 = true;
   bool filters_are_ready = false;
   bool notify_latency = false;
-  bool do_first_rotation = true;
 
   uint blocksize = 512U;
   uint latency_n_frames = 0U;
 
   static constexpr uint nbands = 13U;
 
+  static constexpr uint history_size = 2U;
+
   std::vector<float> data_L;
   std::vector<float> data_R;
 
-  std::array<bool, nbands> band_mute;
-  std::array<bool, nbands> band_bypass;
+  struct Parameters {
+    std::array<bool, nbands> band_mute;
+    std::array<bool, nbands> band_bypass;
+
+    std::array<float, nbands> band_intensity;
+  };
+
+  ParameterSet<Parameters> parameters;
 
   std::array<float, nbands + 1U> frequencies;
-  std::array<float, nbands> band_intensity;
-  std::array<float, nbands> band_last_L;
-  std::array<float, nbands> band_last_R;
-  std::array<float, nbands> band_next_L;
-  std::array<float, nbands> band_next_R;
 
   std::array<std::vector<float>, nbands> band_data_L;
   std::array<std::vector<float>, nbands> band_data_R;
-  std::array<std::vector<float>, nbands> band_gain;
-  std::array<std::vector<float>, nbands> band_second_derivative_L;
-  std::array<std::vector<float>, nbands> band_second_derivative_R;
 
   std::array<std::unique_ptr<FirFilterBase>, nbands> filters;
 
@@ -84,129 +83,50 @@ class Crystalizer : public PluginBase {
 
   void bind_band(const int& n);
 
-  template <typename T1>
-  void enhance_peaks(T1& data_left, T1& data_right) {
-    for (uint n = 0U; n < nbands; n++) {
-      std::copy(data_left.begin(), data_left.end(), band_data_L.at(n).begin());
-      std::copy(data_right.begin(), data_right.end(), band_data_R.at(n).begin());
-
-      filters.at(n)->process(band_data_L.at(n), band_data_R.at(n));
+  void publish_parameters() override;
 
-      /*
-        Later we will need to calculate the second derivative of each band. This
-        is done through the central difference method. In order to calculate
-        the derivative at the last elements of the array we have to know the first
-        element of the next buffer. As we do not have this information the only
-        way to do this calculation is delaying the signal by 1 sample.
-      */
-
-      // last (R,L) becomes the first
-
-      std::rotate(band_data_L.at(n).rbegin(), band_data_L.at(n).rbegin() + 1, band_data_L.at(n).rend());
-      std::rotate(band_data_R.at(n).rbegin(), band_data_R.at(n).rbegin() + 1, band_data_R.at(n).rend());
-
-      if (do_first_rotation) {
-        /*
-          band_data was rotated. Its first values are the last ones from the original array. we have to save them for
-          the next round.
-        */
-
-        band_next_L.at(n) = band_data_L.at(n)[0];
-        band_next_R.at(n) = band_data_R.at(n)[0];
+  template <typename T1>
+  void enhance_peaks(T1& data_left, T1& data_right, const Parameters& p) {
+    /*
+      Later we will need to calculate the second derivative of each band. This is done through the central difference
+      method. In order to calculate the derivative at the last element of the block we have to know the first element
+      of the next one. As we do not have this information the only way to do this calculation is delaying the signal
+      by 1 sample.
+
+      The first two elements of each band buffer hold the last two filtered samples of the previous block. The
+      filtered samples of the current block are written right after them. This way the kernel never has to check
+      where the block edges are.
+    */
 
-        band_last_L.at(n) = 0.0F;
-        band_last_R.at(n) = 0.0F;
+    for (uint n = 0U; n < nbands; n++) {
+      std::span band_L(band_data_L[n].data() + history_size, blocksize);
+      std::span band_R(band_data_R[n].data() + history_size, blocksize);
 
-        band_data_L.at(n)[0] = 0.0F;
-        band_data_R.at(n)[0] = 0.0F;
+      std::copy(data_left.begin(), data_left.end(), band_L.begin());
+      std::copy(data_right.begin(), data_right.end(), band_R.begin());
 
-        do_first_rotation = false;
-      } else {
-        /*
-          band_data was rotated. Its first values are the last ones from the original array. we have to save them for
-          the next round.
-        */
+      filters[n]->process(band_L, band_R);
+    }
 
-        const float L = band_data_L.at(n)[0];
-        const float R = band_data_R.at(n)[0];
+    std::fill(data_left.begin(), data_left.end(), 0.0F);
+    std::fill(data_right.begin(), data_right.end(), 0.0F);
 
-        band_data_L.at(n)[0] = band_next_L.at(n);
-        band_data_R.at(n)[0] = band_next_R.at(n);
+    for (uint n = 0U; n < nbands; n++) {
+      if (!p.band_mute[n]) {
+        // a bypassed band is just delayed by one sample
 
-        band_next_L.at(n) = L;
-        band_next_R.at(n) = R;
-      }
-    }
+        const float intensity = p.band_bypass[n] ? 0.0F : p.band_intensity[n];
 
-    for (uint n = 0U; n < nbands; n++) {
-      // Calculating the second derivative
-
-      if (!band_bypass.at(n)) {
-        for (uint m = 0U; m < blocksize; m++) {
-          const float L = band_data_L.at(n)[m];
-          const float R = band_data_R.at(n)[m];
-
-          if (m > 0 && m < blocksize - 1) {
-            const float& L_lower = band_data_L.at(n)[m - 1U];
-            const float& R_lower = band_data_R.at(n)[m - 1U];
-            const float& L_upper = band_data_L.at(n)[m + 1U];
-            const float& R_upper = band_data_R.at(n)[m + 1U];
-
-            band_second_derivative_L.at(n)[m] = L_upper - 2.0F * L + L_lower;
-            band_second_derivative_R.at(n)[m] = R_upper - 2.0F * R + R_lower;
-          } else if (m == 0U) {
-            const float& L_lower = band_last_L.at(n);
-            const float& R_lower = band_last_R.at(n);
-            const float& L_upper = band_data_L.at(n)[m + 1];
-            const float& R_upper = band_data_R.at(n)[m + 1];
-
-            band_second_derivative_L.at(n)[m] = L_upper - 2.0F * L + L_lower;
-            band_second_derivative_R.at(n)[m] = R_upper - 2.0F * R + R_lower;
-          } else if (m == blocksize - 1) {
-            const float& L_upper = band_next_L.at(n);
-            const float& R_upper = band_next_R.at(n);
-            const float& L_lower = band_data_L.at(n)[m - 1U];
-            const float& R_lower = band_data_R.at(n)[m - 1U];
-
-            band_second_derivative_L.at(n)[m] = L_upper - 2.0F * L + L_lower;
-            band_second_derivative_R.at(n)[m] = R_upper - 2.0F * R + R_lower;
-          }
-        }
-
-        // peak enhancing using second derivative
-
-        for (uint m = 0U; m < blocksize; m++) {
-          const float L = band_data_L.at(n)[m];
-          const float R = band_data_R.at(n)[m];
-          const float& d2L = band_second_derivative_L.at(n)[m];
-          const float& d2R = band_second_derivative_R.at(n)[m];
-
-          band_data_L.at(n)[m] = L - band_intensity.at(n) * d2L;
-          band_data_R.at(n)[m] = R - band_intensity.at(n) * d2R;
-
-          if (m == blocksize - 1U) {
-            band_last_L.at(n) = L;
-            band_last_R.at(n) = R;
-          }
-        }
-      } else {
-        band_last_L.at(n) = band_data_L.at(n)[blocksize - 1];
-        band_last_R.at(n) = band_data_R.at(n)[blocksize - 1];
+        enhance_band(band_data_L[n].data(), data_left.data(), intensity, blocksize);
+        enhance_band(band_data_R[n].data(), data_right.data(), intensity, blocksize);
       }
-    }
-
-    // add bands
 
-    for (uint m = 0U; m < blocksize; m++) {
-      data_left[m] = 0.0F;
-      data_right[m] = 0.0F;
+      // saving the last two samples for the next round
 
-      for (uint n = 0U; n < nbands; n++) {
-        if (!band_mute.at(n)) {
-          data_left[m] += band_data_L.at(n)[m];
-          data_right[m] += band_data_R.at(n)[m];
-        }
-      }
+      std::copy_n(band_data_L[n].begin() + blocksize, history_size, band_data_L[n].begin());
+      std::copy_n(band_data_R[n].begin() + blocksize, history_size, band_data_R[n].begin());
     }
   }
+
+  static void enhance_band(const float* band, float* output, const float& intensity, const uint& count);
 };
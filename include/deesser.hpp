@@ -45,4 +45,5 @@ class Deesser : public PluginBase {
   double detected_port_value = 0.0;
 
  private:
+  lv2::ControlPort detected_port, compression_port;
 };
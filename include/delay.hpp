@@ -40,5 +40,7 @@ class Delay : public PluginBase {
   auto get_latency_seconds() -> float override;
 
  private:
+  lv2::ControlPort latency_port;
+
   uint latency_n_frames = 0U;
 };
@@ -0,0 +1,95 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fftw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/*
+  Estimates how much a signal is delayed relative to a reference using the generalized cross correlation with phase
+  transform (GCC-PHAT). The audio thread only copies the signals to ring buffers. The correlation is calculated by a
+  worker thread a few times per second.
+*/
+
+class DelayEstimator {
+ public:
+  DelayEstimator();
+  DelayEstimator(const DelayEstimator&) = delete;
+  auto operator=(const DelayEstimator&) -> DelayEstimator& = delete;
+  DelayEstimator(const DelayEstimator&&) = delete;
+  auto operator=(const DelayEstimator&&) -> DelayEstimator& = delete;
+  ~DelayEstimator();
+
+  // Forgets the current estimate. Safe to call from the audio thread.
+  void reset(const uint& sampling_rate, const uint& max_delay_samples);
+
+  void push(std::span<const float> signal, std::span<const float> reference);
+
+  // Delay of the signal in samples. Negative while there is no reliable estimate.
+  [[nodiscard]] auto get_delay() const -> int { return delay.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr uint window_size = 65536U;  // about 1.4 s at 48 kHz
+
+  static constexpr uint fft_size = 2U * window_size;  // zero padding avoids circular correlation
+
+  static constexpr uint ring_size = 2U * window_size;
+
+  bool worker_quit = false;
+
+  std::atomic<bool> reset_requested = false;
+
+  std::atomic<uint> rate = 0U;
+
+  std::atomic<uint> max_lag = 0U;
+
+  std::atomic<int> delay = -1;
+
+  int candidate = -1;
+
+  std::vector<float> ring_signal, ring_reference;
+
+  std::atomic<uint64_t> ring_position = 0U;
+
+  uint64_t last_position = 0U;
+
+  fftwf_plan forward_plan = nullptr, backward_plan = nullptr;
+
+  fftwf_complex* complex_input = nullptr;
+  fftwf_complex* complex_output = nullptr;
+  fftwf_complex* cross_spectrum = nullptr;
+
+  float* correlation = nullptr;
+
+  std::mutex worker_mutex;
+
+  std::condition_variable worker_cv;
+
+  std::thread worker;
+
+  void worker_loop();
+
+  void estimate();
+};
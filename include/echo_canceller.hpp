@@ -22,6 +22,7 @@
 #include <speex/speex_echo.h>
 #include <deque>
 #include <numeric>
+#include "delay_estimator.hpp"
 #include "plugin_base.hpp"
 
 #include <speex/speex_preprocess.h>
@@ -49,32 +50,53 @@ class EchoCanceller : public PluginBase {
 
   auto get_latency_seconds() -> float override;
 
+  sigc::signal<void(const float)> estimated_delay;  // milliseconds. Negative while it is unknown
+
  private:
   bool notify_latency = false;
   bool ready = false;
+  bool automatic_delay = true;
+  bool mono_microphone = false;
+  bool stereo_probe = false;
 
   uint filter_length_ms = 100U;
   uint latency_n_frames = 0U;
 
+  static constexpr float max_probe_delay = 0.5F;  // seconds
+
+  uint n_microphones = 2U;
+  uint n_speakers = 1U;
+
+  uint probe_delay = 0U;  // frames
+  uint probe_history_position = 0U;
+
   int residual_echo_suppression = -10;
   int near_end_suppression = -10;
 
-  const float inv_short_max = 1.0F / (SHRT_MAX + 1);
-
-  std::vector<spx_int16_t> data_L;
-  std::vector<spx_int16_t> data_R;
-  std::vector<spx_int16_t> probe_mono;
+  std::vector<float> mic_mix;
+  std::vector<float> mic_interleaved;
+  std::vector<spx_int16_t> mic;
+  std::vector<spx_int16_t> filtered;
   std::vector<spx_int16_t> filtered_L;
   std::vector<spx_int16_t> filtered_R;
 
-  SpeexEchoState* echo_state_L = nullptr;
-  SpeexEchoState* echo_state_R = nullptr;
+  std::vector<float> probe_mix;
+  std::vector<float> probe_interleaved;
+  std::vector<float> probe_delayed;
+  std::vector<float> probe_history;
+  std::vector<spx_int16_t> far_end;
 
+  SpeexEchoState* echo_state = nullptr;
 
   SpeexPreprocessState *state_left = nullptr, *state_right = nullptr;
 
-  void free_speex();
+  DelayEstimator delay_estimator;
 
+  void free_speex();
 
   void init_speex();
+
+  void update_probe_delay();
+
+  void delay_probe();
 };
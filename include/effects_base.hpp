@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <deque>
 #include <set>
 #include "autogain.hpp"
 #include "bass_enhancer.hpp"
@@ -38,6 +39,7 @@
 #include "level_meter.hpp"
 #include "limiter.hpp"
 #include "loudness.hpp"
+#include "lv2_plugin.hpp"
 #include "maximizer.hpp"
 #include "multiband_compressor.hpp"
 #include "multiband_gate.hpp"
@@ -84,6 +86,7 @@ class EffectsBase {
   std::shared_ptr<Gate> gate;
   std::shared_ptr<Limiter> limiter;
   std::shared_ptr<Loudness> loudness;
+  std::shared_ptr<Lv2Plugin> lv2_plugin;
   std::shared_ptr<Maximizer> maximizer;
   std::shared_ptr<MultibandCompressor> multiband_compressor;
   std::shared_ptr<MultibandGate> multiband_gate;
@@ -109,8 +112,20 @@ class EffectsBase {
 
   std::string schema_base_path;
 
+  std::atomic<bool> voice_active = true;  // declared before the plugins so that it outlives them
+
   std::map<std::string, std::shared_ptr<PluginBase>> plugins;
 
+  /*
+    Plugins removed from the chain are kept connected to PipeWire for a while, oldest first. Putting one of them back,
+    what users do all the time while comparing effects, does not have to create and connect a new filter. Only the
+    last ones are kept because each of them holds its filter node and its buffers.
+  */
+
+  static constexpr uint max_unused_plugins = 4U;
+
+  std::deque<std::string> unused_plugins;
+
   std::vector<pw_proxy*> list_proxies, list_proxies_listen_mic;
 
   std::vector<sigc::connection> connections;
@@ -126,4 +141,10 @@ class EffectsBase {
   void deactivate_filters();
 
   void broadcast_pipeline_latency();
+
+  void share_loudness_analysis();
+
+  void share_voice_activity();
+
+  void update_async_plugins();
 };
@@ -52,6 +52,8 @@ class Equalizer : public PluginBase {
   static constexpr uint max_bands = 32U;
 
  private:
+  lv2::ControlPort latency_port;
+
   GSettings *settings_left = nullptr, *settings_right = nullptr;
 
   uint latency_n_frames = 0U;
@@ -44,4 +44,5 @@ class Exciter : public PluginBase {
   double harmonics_port_value = 0.0;
 
  private:
+  lv2::ControlPort harmonics_port;
 };
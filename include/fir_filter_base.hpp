@@ -91,10 +91,19 @@ class FirFilterBase {
 
   Convproc* conv = nullptr;
 
+  enum class KernelType { lowpass, highpass, bandpass };
+
   [[nodiscard]] auto create_lowpass_kernel(const float& cutoff, const float& transition_band) const
       -> std::vector<float>;
 
-  void setup_zita();
+  [[nodiscard]] auto create_highpass_kernel(const float& cutoff, const float& transition_band) const
+      -> std::vector<float>;
 
-  static void direct_conv(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& c);
+  [[nodiscard]] auto create_bandpass_kernel(const float& low_cutoff,
+                                            const float& high_cutoff,
+                                            const float& transition_band) const -> std::vector<float>;
+
+  void load_kernel(const KernelType& type);
+
+  void setup_zita();
 };
@@ -58,6 +58,9 @@ class Gate : public PluginBase {
   double gating_port_value = 0.0;
 
  private:
+  lv2::ControlPort latency_port, attack_zone_start_port, attack_threshold_port, release_zone_start_port,
+      release_threshold_port, reduction_port, sidechain_port, curve_port, envelope_port, max_reduction_port;
+
   uint latency_n_frames = 0U;
 
   std::vector<pw_proxy*> list_proxies;
@@ -19,7 +19,7 @@
 
 #pragma once
 
-#include <ebur128.h>
+#include "loudness_analyzer.hpp"
 #include "plugin_base.hpp"
 
 class LevelMeter : public PluginBase {
@@ -55,8 +55,11 @@ class LevelMeter : public PluginBase {
                     )>
       results;  // range
 
+  // AutoGain instances placed after this meter reuse its analysis when they see the same signal
+  const std::shared_ptr<LoudnessAnalyzer> analyzer = std::make_shared<LoudnessAnalyzer>();
+
  private:
-  bool ebur128_ready = false;
+  bool analyzer_ready = false;
 
   uint old_rate = 0U;
 
@@ -69,11 +72,7 @@ class LevelMeter : public PluginBase {
   double true_peak_L = 0.0;
   double true_peak_R = 0.0;
 
-  std::vector<float> data;
-
-  ebur128_state* ebur_state = nullptr;
-
   std::vector<std::thread> mythreads;
 
-  auto init_ebur128() -> bool;
+  auto init_analyzer() -> bool;
 };
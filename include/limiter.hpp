@@ -51,6 +51,8 @@ class Limiter : public PluginBase {
   float sidechain_r_port_value = 0.0F;
 
  private:
+  lv2::ControlPort latency_port, gain_l_port, gain_r_port, sidechain_l_port, sidechain_r_port;
+
   uint latency_n_frames = 0U;
 
   std::vector<pw_proxy*> list_proxies;
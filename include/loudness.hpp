@@ -43,5 +43,7 @@ class Loudness : public PluginBase {
   auto get_latency_seconds() -> float override;
 
  private:
+  lv2::ControlPort latency_port;
+
   uint latency_n_frames = 0U;
 };
@@ -0,0 +1,191 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+#include "util.hpp"
+
+/*
+  EBU R128 loudness analysis. The K-weighting filters run on both channels at once and the momentary and short-term
+  windows are running sums of 10 ms segments. Integrated loudness and loudness range are computed from histograms of
+  the gating blocks, so their cost does not depend on how long the history is.
+*/
+
+class LoudnessAnalyzer {
+ public:
+  LoudnessAnalyzer() = default;
+  LoudnessAnalyzer(const LoudnessAnalyzer&) = delete;
+  auto operator=(const LoudnessAnalyzer&) -> LoudnessAnalyzer& = delete;
+  LoudnessAnalyzer(const LoudnessAnalyzer&&) = delete;
+  auto operator=(const LoudnessAnalyzer&&) -> LoudnessAnalyzer& = delete;
+  ~LoudnessAnalyzer() = default;
+
+  // Allocates memory. It must not be called from the realtime thread.
+  void init(const uint& sampling_rate, const bool& measure_true_peak, const uint& max_history_seconds = 0U);
+
+  // Allocates memory. The gating blocks that fit in the new history are kept.
+  void set_maximum_history(const uint& seconds);
+
+  void process(std::span<const float> left, std::span<const float> right, const uint64_t& cycle);
+
+  /*
+    When the source analyzer already processed exactly the same samples in the current graph cycle we take its
+    filters state instead of filtering everything again. Only the gating histograms remain ours. Returns false when
+    the analysis could not be reused and the caller has to process the samples.
+  */
+
+  auto follow(LoudnessAnalyzer& source,
+              std::span<const float> left,
+              std::span<const float> right,
+              const uint64_t& cycle) -> bool;
+
+  [[nodiscard]] auto is_ready() const -> bool { return ready; }
+
+  [[nodiscard]] auto momentary() const -> double;
+
+  [[nodiscard]] auto shortterm() const -> double;
+
+  [[nodiscard]] auto integrated() -> double;
+
+  [[nodiscard]] auto relative_threshold() -> double;
+
+  [[nodiscard]] auto range() -> double;
+
+  // linear values
+
+  [[nodiscard]] auto true_peak(const uint& channel) const -> double;
+
+  [[nodiscard]] auto previous_sample_peak(const uint& channel) const -> double;
+
+ private:
+  static constexpr uint momentary_segments = 40U;   // 400 ms
+  static constexpr uint shortterm_segments = 300U;  // 3 s
+  static constexpr uint block_segments = 10U;       // a new gating block every 100 ms
+  static constexpr uint n_blocks_kept = 16U;
+
+  static constexpr uint n_taps_per_phase = 12U;  // true peak interpolator with 4 phases
+
+  using v2d = double __attribute__((vector_size(16)));
+  using v4f = float __attribute__((vector_size(16)));
+
+  struct Block {
+    double momentary_energy = 0.0;
+    double shortterm_energy = 0.0;
+
+    bool has_shortterm = false;
+  };
+
+  /*
+    Everything that depends only on the input samples. It is a plain copyable struct so that an analyzer fed with
+    the same signal can take it as a whole.
+  */
+
+  struct Frontend {
+    std::array<v2d, 2U> pre_filter_state{}, rlb_filter_state{};
+
+    std::vector<int64_t> segments;  // fixed point mean energy of each 10 ms segment
+
+    uint64_t n_segments = 0U;
+
+    uint segment_position = 0U;
+
+    double segment_energy = 0.0;
+
+    int64_t momentary_sum = 0;
+    int64_t shortterm_sum = 0;
+
+    std::array<Block, n_blocks_kept> blocks{};
+
+    uint64_t n_blocks = 0U;
+
+    std::array<std::array<float, 2U * n_taps_per_phase>, 2U> true_peak_history{};
+
+    uint true_peak_position = 0U;
+
+    std::array<double, 2U> true_peak{}, sample_peak{};
+  };
+
+  class Histogram {
+   public:
+    void init(const uint& history_size);
+
+    void set_history_size(const uint& history_size);
+
+    void add(const double& energy);
+
+    // mean energy of the blocks louder than the threshold and how many blocks there are
+    [[nodiscard]] auto gated_energy(const double& threshold_loudness) const -> std::pair<double, uint64_t>;
+
+    [[nodiscard]] auto percentile_loudness(const double& threshold_loudness, const double& fraction) const -> double;
+
+   private:
+    std::vector<uint64_t> counts;
+
+    std::vector<int> history;  // bin of each block in the history. Negative for blocks below the absolute gate
+
+    uint64_t n_added = 0U;
+  };
+
+  bool ready = false;
+
+  std::mutex mutex;  // other analyzers only try to lock it
+
+  bool use_true_peak = false;
+
+  uint rate = 0U;
+
+  uint segment_size = 0U;
+
+  uint64_t last_cycle = 0U;
+
+  uint64_t blocks_before_cycle = 0U;
+
+  uint64_t blocks_consumed = 0U;
+
+  bool gating_changed = true;
+
+  double cached_integrated = 0.0, cached_relative = 0.0, cached_range = 0.0;
+
+  std::array<double, 3U> pre_b{}, pre_a{}, rlb_b{}, rlb_a{};
+
+  std::array<v4f, n_taps_per_phase> true_peak_coefficients{};
+
+  std::vector<float> last_left, last_right;
+
+  Frontend frontend;
+
+  Histogram integrated_histogram, range_histogram;
+
+  void calculate_filters_coefficients();
+
+  void filter_samples(std::span<const float> left, std::span<const float> right);
+
+  void close_segment();
+
+  void update_true_peak(std::span<const float> left, std::span<const float> right);
+
+  void consume_blocks();
+
+  void update_gated_measures();
+};
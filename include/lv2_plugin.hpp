@@ -0,0 +1,76 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "plugin_base.hpp"
+
+/*
+  Runs any stereo LV2 plugin chosen by the user. Its control values are kept in a dictionary indexed by the port
+  symbol because the keys of the schema can not depend on the plugin.
+*/
+
+class Lv2Plugin : public PluginBase {
+ public:
+  Lv2Plugin(const std::string& tag,
+            const std::string& schema,
+            const std::string& schema_path,
+            PipeManager* pipe_manager);
+  Lv2Plugin(const Lv2Plugin&) = delete;
+  auto operator=(const Lv2Plugin&) -> Lv2Plugin& = delete;
+  Lv2Plugin(const Lv2Plugin&&) = delete;
+  auto operator=(const Lv2Plugin&&) -> Lv2Plugin& = delete;
+  ~Lv2Plugin() override;
+
+  void setup() override;
+
+  void process(std::span<float>& left_in,
+               std::span<float>& right_in,
+               std::span<float>& left_out,
+               std::span<float>& right_out) override;
+
+  auto get_latency_seconds() -> float override;
+
+  // The input control ports of the loaded plugin with their default values
+  [[nodiscard]] auto get_controls() const -> std::vector<lv2::Port>;
+
+  // Copies to gsettings the values and the state set by the native ui
+  void save_control_values();
+
+  sigc::signal<void()> plugin_changed;
+
+ private:
+  std::string plugin_uri;
+
+  lv2::ControlPort latency_port;
+
+  uint latency_n_frames = 0U;
+
+  // When reload is true the plugin is loaded again even if its uri did not change
+  void load_plugin(const bool& reload = false);
+
+  void apply_control_values(lv2::Lv2Wrapper* wrapper);
+
+  [[nodiscard]] auto get_saved_state() const -> std::vector<lv2::StateProperty>;
+
+  void save_state();
+
+  // A different state needs a new instance. It is not done while a new plugin uri is waiting to be loaded.
+  void load_saved_state();
+};
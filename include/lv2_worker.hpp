@@ -0,0 +1,101 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <lilv/lilv.h>
+#include <lv2/worker/worker.h>
+#include <atomic>
+#include <cstdint>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace lv2 {
+
+/*
+  Host side of the LV2 Worker extension. The plugin schedules non realtime work (loading files, recomputing filter
+  banks) from run(). It is done in a thread of its own and the responses are delivered back in the realtime thread
+  after the next run(). Messages go through lock-free rings. So the realtime thread never waits for the worker.
+*/
+
+class Worker {
+ public:
+  Worker();
+  Worker(const Worker&) = delete;
+  auto operator=(const Worker&) -> Worker& = delete;
+  Worker(const Worker&&) = delete;
+  auto operator=(const Worker&&) -> Worker& = delete;
+  ~Worker();
+
+  // Starts the thread if the instance implements the worker interface. Main thread only.
+  void start(LilvInstance* instance);
+
+  // Waits for the work in progress. It has to be called before the instance is deactivated. Main thread only.
+  void stop();
+
+  // Called by the plugin through the schedule feature
+  auto schedule(const uint32_t& size, const void* data) -> LV2_Worker_Status;
+
+  // Called in the realtime thread after run()
+  void deliver_responses();
+
+  LV2_Worker_Schedule schedule_data;
+
+ private:
+  // Single producer and single consumer ring of messages prefixed by their size
+  class Ring {
+   public:
+    explicit Ring(const size_t& size);
+
+    auto write(const uint32_t& size, const void* data) -> bool;
+
+    // false when the ring is empty. The message is copied to data.
+    auto read(uint32_t& size, std::vector<uint8_t>& data) -> bool;
+
+   private:
+    std::vector<uint8_t> buffer;
+
+    std::atomic<size_t> write_position = 0U, read_position = 0U;
+
+    void copy_in(const size_t& position, const void* data, const size_t& size);
+
+    void copy_out(const size_t& position, void* data, const size_t& size) const;
+  };
+
+  static constexpr size_t ring_size = 16384U;
+
+  LV2_Handle handle = nullptr;
+
+  const LV2_Worker_Interface* iface = nullptr;
+
+  Ring requests, responses;
+
+  std::vector<uint8_t> request_data, response_data;  // the response buffer is only used by the realtime thread
+
+  std::atomic<bool> quit = false;
+
+  std::counting_semaphore<> requests_available{0};
+
+  std::thread thread;
+
+  void work();
+};
+
+}  // namespace lv2
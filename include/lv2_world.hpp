@@ -0,0 +1,145 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <lilv/lilv.h>
+#include <sigc++/sigc++.h>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lv2 {
+
+enum PortType { TYPE_CONTROL, TYPE_AUDIO, TYPE_ATOM };
+
+struct Port {
+  PortType type;  // Datatype
+
+  uint index;  // Port index
+
+  std::string name;
+
+  std::string symbol;
+
+  float value;  // Control value (if applicable)
+
+  bool is_input;  // True if an input port
+
+  bool optional;  // True if the connection is optional
+
+  float min = 0.0F;  // Control range (if applicable)
+
+  float max = 1.0F;
+
+  bool toggled = false;  // True if the control is an on/off switch
+
+  bool integer = false;  // True if the control only takes integer values. Enumerations included.
+
+  bool reports_latency = false;  // True if the plugin reports its latency in this output
+};
+
+struct PluginInfo {
+  std::string bundle_path;
+
+  int64_t bundle_mtime = 0;
+
+  uint n_audio_in = 0U;
+  uint n_audio_out = 0U;
+
+  std::vector<Port> ports;  // the value of the control ports is their default
+};
+
+struct PluginDescription {
+  std::string uri;
+
+  std::string name;
+};
+
+/*
+  The LV2 world is shared by every plugin wrapper in the process. Parsing the Turtle files of all the installed bundles
+  is slow. So it is done only once, in a background thread started when the application starts. The port metadata of
+  the plugins we use is also saved to disk. As long as the plugin bundle is not modified a wrapper can be created from
+  it without waiting for the world.
+*/
+
+class World {
+ public:
+  World(const World&) = delete;
+  auto operator=(const World&) -> World& = delete;
+  World(const World&&) = delete;
+  auto operator=(const World&&) -> World& = delete;
+
+  static auto get() -> World&;
+
+  // Starts loading the installed bundles. Calling it more than once does nothing.
+  void load_async();
+
+  // Main thread only. True once world_loaded was emitted.
+  [[nodiscard]] auto is_ready() const -> bool;
+
+  // nullptr when the plugin is not installed
+  auto find_plugin_info(const std::string& uri) -> const PluginInfo*;
+
+  // Waits for the world to be loaded. nullptr when the plugin is not installed.
+  auto find_plugin(const std::string& uri) -> const LilvPlugin*;
+
+  // Waits for the world to be loaded
+  auto get_world() -> LilvWorld*;
+
+  // Waits for the world to be loaded. Only the plugins with 2 audio inputs and 2 audio outputs are listed.
+  auto list_stereo_plugins() -> std::vector<PluginDescription>;
+
+  // lilv is not thread safe. It has to be held while using the world or the plugins it contains.
+  std::mutex mutex;
+
+  // Emitted in the main thread when the world is loaded. Waiting for it does not block anymore after that.
+  sigc::signal<void()> world_loaded;
+
+ private:
+  World();
+  ~World();
+
+  LilvWorld* world = nullptr;
+
+  std::once_flag load_flag;
+
+  std::shared_future<void> loaded;
+
+  bool ready = false;
+
+  std::mutex info_mutex;
+
+  std::unordered_map<std::string, PluginInfo> info_cache;
+
+  std::filesystem::path cache_file;
+
+  void read_cache_file();
+
+  void write_cache_file();
+
+  auto query_plugin_info(const LilvPlugin* plugin) -> PluginInfo;
+
+  static auto get_bundle_mtime(const std::string& bundle_path) -> int64_t;
+};
+
+}  // namespace lv2
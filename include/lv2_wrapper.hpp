@@ -20,7 +20,6 @@
 #pragma once
 
 #include <dlfcn.h>
-#include <lilv/lilv.h>
 #include <lv2/atom/atom.h>
 #include <lv2/buf-size/buf-size.h>
 #include <lv2/core/lv2.h>
@@ -30,12 +29,16 @@
 #include <lv2/lv2plug.in/ns/ext/urid/urid.h>
 #include <lv2/options/options.h>
 #include <lv2/parameters/parameters.h>
+#include <lv2/state/state.h>
 #include <lv2/ui/ui.h>
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <span>
 #include <thread>
 #include <unordered_map>
+#include "lv2_worker.hpp"
+#include "lv2_world.hpp"
 #include "string_literal_wrapper.hpp"
 #include "util.hpp"
 
@@ -47,22 +50,29 @@ using namespace std::string_literals;
 
 #define LV2_UI_makeSONameResident LV2_UI_PREFIX "makeSONameResident"
 
-enum PortType { TYPE_CONTROL, TYPE_AUDIO, TYPE_ATOM };
+// A control port resolved from its symbol only once. Reading it in the realtime thread is a single array access.
+struct ControlPort {
+  int index = -1;  // position in the ports table. Negative when the plugin does not have the port
+};
 
-struct Port {
-  PortType type;  // Datatype
+struct PortValue {
+  ControlPort port;
 
-  uint index;  // Port index
+  float value = 0.0F;
+};
 
-  std::string name;
+// A property saved through the LV2 State extension. Keys and types are kept as uris so they do not depend on our
+// urid map.
+struct StateProperty {
+  std::string key;
 
-  std::string symbol;
+  std::string type;
 
-  float value;  // Control value (if applicable)
+  uint32_t flags = 0U;
 
-  bool is_input;  // True if an input port
+  std::vector<uint8_t> value;
 
-  bool optional;  // True if the connection is optional
+  auto operator==(const StateProperty&) const -> bool = default;
 };
 
 class Lv2Wrapper {
@@ -76,7 +86,16 @@ class Lv2Wrapper {
 
   bool found_plugin = false;
 
-  auto create_instance(const uint& rate) -> bool;
+  /*
+    Called by the realtime thread from setup(). The current instance stops being used right away. Instantiating,
+    parking the old instance and starting or stopping the LV2 worker are done in the main thread. The new instance is
+    taken by a later has_instance() call.
+  */
+
+  void create_instance(const uint& rate);
+
+  // Main thread version for a wrapper the realtime thread does not use yet. The instance is ready when it returns.
+  void prepare_instance(const uint& rate);
 
   void set_n_samples(const uint& value);
 
@@ -98,14 +117,28 @@ class Lv2Wrapper {
 
   void activate();
 
-  void run() const;
+  void run();
 
   void deactivate();
 
   void set_control_port_value(const std::string& symbol, const float& value);
 
+  // Cheaper than setting the values one by one. They reach the plugin in the same block.
+  void set_control_port_values(std::span<const PortValue> values);
+
+  // Publishes the values set since the last commit. The realtime thread applies all of them before the same block.
+  void commit_control_port_values();
+
   auto get_control_port_value(const std::string& symbol) -> float;
 
+  [[nodiscard]] auto find_control_port(const std::string& symbol) const -> ControlPort;
+
+  [[nodiscard]] auto get_ports() const -> const std::vector<Port>& { return ports; }
+
+  [[nodiscard]] auto get_control_port_value(const ControlPort& port) const -> float {
+    return (port.index < 0) ? 0.0F : ports[port.index].value;
+  }
+
   auto has_instance() -> bool;
 
   void load_ui();
@@ -120,23 +153,27 @@ class Lv2Wrapper {
 
   void set_ui_update_rate(const uint& value);
 
-  void ui_port_event(const uint& port_index, const float& value);
-
   void native_ui_to_gsettings();
 
-  template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper>
-  void bind_key_bool(GSettings* settings) {
-    set_control_port_value(key_wrapper.msg.data(),
-                           static_cast<float>(g_settings_get_boolean(settings, gkey_wrapper.msg.data())));
+  [[nodiscard]] auto has_state_interface() const -> bool;
+
+  // Only plain old data properties are saved. The caller has to make sure run() is not running at the same time.
+  auto save_state() -> std::vector<StateProperty>;
+
+  /*
+    Main thread only. The properties are restored into every instance this wrapper prepares, before it is activated.
+    So the realtime thread never runs an instance whose state is being restored.
+  */
+
+  void set_state(std::vector<StateProperty> properties);
 
-    g_signal_connect(settings, ("changed::"s + gkey_wrapper.msg.data()).c_str(),
-                     G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                       auto* self = static_cast<Lv2Wrapper*>(user_data);
+  [[nodiscard]] auto get_state() const -> const std::vector<StateProperty>&;
 
-                       self->set_control_port_value(key_wrapper.msg.data(),
-                                                    static_cast<float>(g_settings_get_boolean(settings, key)));
-                     }),
-                     this);
+  template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper>
+  void bind_key_bool(GSettings* settings) {
+    bind_key(settings, key_wrapper.msg.data(), gkey_wrapper.msg.data(), [](GSettings* settings, const char* key) {
+      return static_cast<float>(g_settings_get_boolean(settings, key));
+    });
 
     gsettings_sync_funcs.emplace_back([=, this]() {
       g_settings_set_boolean(settings, gkey_wrapper.msg.data(),
@@ -146,17 +183,9 @@ class Lv2Wrapper {
 
   template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper>
   void bind_key_enum(GSettings* settings) {
-    set_control_port_value(key_wrapper.msg.data(),
-                           static_cast<float>(g_settings_get_enum(settings, gkey_wrapper.msg.data())));
-
-    g_signal_connect(settings, ("changed::"s + gkey_wrapper.msg.data()).c_str(),
-                     G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                       auto* self = static_cast<Lv2Wrapper*>(user_data);
-
-                       self->set_control_port_value(key_wrapper.msg.data(),
-                                                    static_cast<float>(g_settings_get_enum(settings, key)));
-                     }),
-                     this);
+    bind_key(settings, key_wrapper.msg.data(), gkey_wrapper.msg.data(), [](GSettings* settings, const char* key) {
+      return static_cast<float>(g_settings_get_enum(settings, key));
+    });
 
     gsettings_sync_funcs.emplace_back([=, this]() {
       g_settings_set_enum(settings, gkey_wrapper.msg.data(),
@@ -166,17 +195,9 @@ class Lv2Wrapper {
 
   template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper>
   void bind_key_int(GSettings* settings) {
-    set_control_port_value(key_wrapper.msg.data(),
-                           static_cast<float>(g_settings_get_int(settings, gkey_wrapper.msg.data())));
-
-    g_signal_connect(settings, ("changed::"s + gkey_wrapper.msg.data()).c_str(),
-                     G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                       auto* self = static_cast<Lv2Wrapper*>(user_data);
-
-                       self->set_control_port_value(key_wrapper.msg.data(),
-                                                    static_cast<float>(g_settings_get_int(settings, key)));
-                     }),
-                     this);
+    bind_key(settings, key_wrapper.msg.data(), gkey_wrapper.msg.data(), [](GSettings* settings, const char* key) {
+      return static_cast<float>(g_settings_get_int(settings, key));
+    });
 
     gsettings_sync_funcs.emplace_back([=, this]() {
       g_settings_set_int(settings, gkey_wrapper.msg.data(),
@@ -186,17 +207,9 @@ class Lv2Wrapper {
 
   template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper>
   void bind_key_double(GSettings* settings) {
-    set_control_port_value(key_wrapper.msg.data(),
-                           static_cast<float>(g_settings_get_double(settings, gkey_wrapper.msg.data())));
-
-    g_signal_connect(settings, ("changed::"s + gkey_wrapper.msg.data()).c_str(),
-                     G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                       auto* self = static_cast<Lv2Wrapper*>(user_data);
-
-                       self->set_control_port_value(key_wrapper.msg.data(),
-                                                    static_cast<float>(g_settings_get_double(settings, key)));
-                     }),
-                     this);
+    bind_key(settings, key_wrapper.msg.data(), gkey_wrapper.msg.data(), [](GSettings* settings, const char* key) {
+      return static_cast<float>(g_settings_get_double(settings, key));
+    });
 
     gsettings_sync_funcs.emplace_back([=, this]() {
       g_settings_set_double(settings, gkey_wrapper.msg.data(),
@@ -206,26 +219,11 @@ class Lv2Wrapper {
 
   template <StringLiteralWrapper key_wrapper, StringLiteralWrapper gkey_wrapper, bool lower_bound = true>
   void bind_key_double_db(GSettings* settings) {
-    auto key_v = g_settings_get_double(settings, gkey_wrapper.msg.data());
-
-    auto linear_v =
-        (!lower_bound && key_v <= util::minimum_db_d_level) ? 0.0F : static_cast<float>(util::db_to_linear(key_v));
-
-    set_control_port_value(key_wrapper.msg.data(), linear_v);
-
-    g_signal_connect(settings, ("changed::"s + gkey_wrapper.msg.data()).c_str(),
-                     G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                       auto* self = static_cast<Lv2Wrapper*>(user_data);
-
-                       auto key_v = g_settings_get_double(settings, gkey_wrapper.msg.data());
+    bind_key(settings, key_wrapper.msg.data(), gkey_wrapper.msg.data(), [](GSettings* settings, const char* key) {
+      const auto key_v = g_settings_get_double(settings, key);
 
-                       auto linear_v = (!lower_bound && key_v <= util::minimum_db_d_level)
-                                           ? 0.0F
-                                           : static_cast<float>(util::db_to_linear(key_v));
-
-                       self->set_control_port_value(key_wrapper.msg.data(), linear_v);
-                     }),
-                     this);
+      return (!lower_bound && key_v <= util::minimum_db_d_level) ? 0.0F : static_cast<float>(util::db_to_linear(key_v));
+    });
 
     gsettings_sync_funcs.emplace_back([=, this]() {
       const auto linear_v = get_control_port_value(key_wrapper.msg.data());
@@ -239,11 +237,28 @@ class Lv2Wrapper {
  private:
   std::string plugin_uri;
 
-  LilvWorld* world = nullptr;
+  std::atomic<const LilvPlugin*> plugin = nullptr;  // resolved in the main thread after the shared world is loaded
+
+  sigc::connection world_loaded_connection;
+
+  LilvInstance* instance = nullptr;  // used by the realtime thread
+
+  uint instance_rate = 0U;
 
-  const LilvPlugin* plugin = nullptr;
+  /*
+    Instances handed between the threads. At most one of them is in flight because the realtime thread only retires
+    instances the main thread prepared, and the main thread parks the retired one before preparing the next.
+  */
 
-  LilvInstance* instance = nullptr;
+  std::atomic<LilvInstance*> prepared_instance = nullptr, retired_instance = nullptr;
+
+  std::atomic<uint> prepared_rate = 0U, retired_rate = 0U, requested_rate = 0U;
+
+  bool instance_published = false;  // main thread
+
+  std::mutex instance_mutex;
+
+  guint instance_source_id = 0U;
 
   LV2UI_Handle ui_handle = nullptr;
 
@@ -265,20 +280,126 @@ class Lv2Wrapper {
 
   std::vector<Port> ports;
 
+  /*
+    Deactivated instances created for the rates used before, oldest first. PipeWire often goes back and forth between
+    the same rates, like 44.1 and 48 kHz, and instantiating some plugins takes much longer than a quantum. Only the
+    main thread uses them.
+  */
+
+  static constexpr size_t max_idle_instances = 2U;
+
+  std::vector<std::pair<uint, LilvInstance*>> idle_instances;  // rate and instance
+
+  Worker worker;
+
+  std::unordered_map<std::string, uint> control_ports;  // symbol -> position in the ports table
+
+  std::array<uint, 4U> audio_in_ports{};   // the first 2 are the main input and the others the probe
+  std::array<uint, 2U> audio_out_ports{};
+
   std::vector<std::function<void()>> gsettings_sync_funcs;
 
+  struct KeyBinding {
+    ControlPort port;
+
+    float (*read_key)(GSettings* settings, const char* key) = nullptr;
+  };
+
+  /*
+    All the keys changed at once, like the ones written by a preset between g_settings_delay and g_settings_apply,
+    arrive in a single change-event. So their values are requested with one call instead of one per key.
+  */
+
+  std::unordered_map<GSettings*, std::unordered_map<GQuark, KeyBinding>> gsettings_bindings;
+
   std::unordered_map<std::string, LV2_URID> map_uri_to_urid;
   std::unordered_map<LV2_URID, std::string> map_urid_to_uri;
 
+  std::vector<StateProperty> saved_state;  // only used while the plugin saves its state
+
+  const std::unordered_map<LV2_URID, const StateProperty*>* restored_state = nullptr;
+
+  std::vector<StateProperty> state;  // restored into the new instances
+
   const std::array<const LV2_Feature, 1U> static_features{{{LV2_BUF_SIZE__boundedBlockLength, nullptr}}};
 
   std::mutex ui_mutex;
 
-  void check_required_features();
+  /*
+    The realtime thread is the only one writing to the control values the instance reads. The other threads request a
+    change and it is committed in a main loop idle callback. So everything set in the same main loop iteration, like
+    all the keys of a preset, reaches the plugin in the same block. Only the latest value of each port is kept.
+  */
+
+  std::mutex changes_mutex;
+
+  guint commit_source_id = 0U;
+
+  std::vector<float> requested_values;  // latest value requested for each port
+
+  std::vector<uint> pending_changes;  // positions in the ports table waiting for the next commit
+
+  std::vector<bool> is_pending;
+
+  // Committed changes not applied yet. The realtime thread only tries to take this lock. It never waits for it.
+
+  std::atomic_flag staging_lock;
+
+  std::vector<float> staged_values;
+
+  std::vector<uint> staged_changes;
+
+  std::vector<bool> is_staged;
+
+  /*
+    Ports whose value the native ui has not seen yet. The realtime thread marks the output ports that changed in the
+    last block and the main thread marks the inputs it changed. The ui thread forwards only these ports.
+  */
+
+  std::atomic<bool> ui_active = false;
+
+  std::vector<std::atomic<uint64_t>> ui_dirty_ports;
+
+  std::vector<uint> output_control_ports;  // positions in the ports table
+
+  std::vector<float> ui_output_values;  // output values already marked. Only used by the realtime thread.
+
+  void create_port_tables();
+
+  void bind_key(GSettings* settings,
+                const std::string& symbol,
+                const char* gkey,
+                float (*read_key)(GSettings* settings, const char* key));
+
+  void on_settings_change_event(GSettings* settings, std::span<const GQuark> keys);
+
+  void stage_control_port_value(const uint& port, const float& value, const bool& from_ui);
+
+  void schedule_commit();
+
+  void request_control_port_value(const uint& port, const float& value, const bool& from_ui = false);
+
+  void mark_ui_dirty(const uint& port);
+
+  void mark_changed_outputs();
+
+  void apply_staged_changes();
+
+  void resolve_plugin();
+
+  void retire_instance(LilvInstance* old_instance, const uint& old_rate);
+
+  void schedule_instance_update();
+
+  void update_instance();
+
+  void park_instance(LilvInstance* old_instance, const uint& old_rate);
+
+  auto instantiate(const LilvPlugin* lilv_plugin, const uint& rate) -> LilvInstance*;
 
-  void create_ports();
+  void connect_control_ports(LilvInstance* target);
 
-  void connect_control_ports();
+  auto restore_state(LilvInstance* target) -> bool;
 
   auto map_urid(const std::string& uri) -> LV2_URID;
 };
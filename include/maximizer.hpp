@@ -47,5 +47,7 @@ class Maximizer : public PluginBase {
   double reduction_port_value = 0.0;
 
  private:
+  lv2::ControlPort latency_port, reduction_port;
+
   uint latency_n_frames = 0U;
 };
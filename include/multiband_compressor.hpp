@@ -57,6 +57,10 @@ class MultibandCompressor : public PluginBase {
   std::array<float, n_bands> reduction_port_array = {0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F};
 
  private:
+  lv2::ControlPort latency_port;
+
+  std::array<lv2::ControlPort, n_bands> frequency_range_end_ports, envelope_ports, curve_ports, reduction_ports;
+
   uint latency_n_frames = 0U;
 
   std::vector<pw_proxy*> list_proxies;
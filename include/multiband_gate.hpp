@@ -61,6 +61,11 @@ class MultibandGate : public PluginBase {
   std::array<double, n_bands> gating_array = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 
  private:
+  lv2::ControlPort latency_port;
+
+  std::array<lv2::ControlPort, n_bands> frequency_range_end_ports, envelope_ports, curve_ports, reduction_ports,
+      max_reduction_ports;
+
   uint latency_n_frames = 0U;
 
   std::vector<pw_proxy*> list_proxies;
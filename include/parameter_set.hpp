@@ -0,0 +1,70 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+/*
+  Hands a group of parameters from the main thread to the realtime thread as a whole. The main thread edits the draft
+  and publishes it when the transaction is complete. The realtime thread takes the latest published copy once per
+  block. So it never sees a mix of old and new values and neither side ever waits for the other.
+
+  There are three copies: the last one written by the main thread, the one being read and the latest published one.
+  Publishing and taking a copy are a single atomic exchange of the index of the middle one.
+*/
+
+template <typename T>
+class ParameterSet {
+  static_assert(std::is_trivially_copyable_v<T>, "copying the parameters must not allocate memory");
+
+ public:
+  T draft{};  // only used in the main thread
+
+  void publish() {
+    slots[back] = draft;
+
+    back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index_mask;
+  }
+
+  // Only one thread at a time may read the parameters. The reference is valid until the next call.
+  auto read() -> const T& {
+    if ((middle.load(std::memory_order_relaxed) & fresh) != 0U) {
+      front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+    }
+
+    return slots[front];
+  }
+
+ private:
+  static constexpr uint index_mask = 3U;
+
+  static constexpr uint fresh = 4U;  // the middle copy was published and not taken yet
+
+  std::array<T, 3U> slots{};
+
+  uint back = 0U;  // only used in the main thread
+
+  uint front = 1U;  // only used in the realtime thread
+
+  std::atomic<uint> middle = 2U;
+};
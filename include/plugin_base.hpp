@@ -21,11 +21,15 @@
 
 #include <pipewire/filter.h>
 #include <spa/param/latency-utils.h>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <ranges>
 #include <span>
 #include "lv2_wrapper.hpp"
+#include "parameter_set.hpp"
 #include "pipe_manager.hpp"
+#include "simd.hpp"
 #include "tags_plugin_name.hpp"
 
 class PluginBase {
@@ -78,9 +82,11 @@ class PluginBase {
 
   uint rate = 0U;
 
+  uint64_t clock_position = 0U;  // the same for every filter processing the current graph cycle
+
   bool package_installed = true;
 
-  bool bypass = false;
+  bool bypass = false;  // taken by the realtime thread at the beginning of each block. Changed through set_bypass().
 
   bool connected_to_pw = false;
 
@@ -102,6 +108,8 @@ class PluginBase {
 
   void set_post_messages(const bool& state);
 
+  void set_bypass(const bool& state);
+
   auto connect_to_pw() -> bool;
 
   void disconnect_from_pw();
@@ -130,8 +138,43 @@ class PluginBase {
 
   virtual void update_probe_links();
 
+  // Called by the filter when the sampling rate or the quantum changes
+  void run_setup();
+
+  /*
+    Called by the filter before the sampling rate or the quantum changes. It returns false while the worker of the
+    asynchronous mode is still busy with a block. The filter outputs silence and tries again in the next cycle.
+  */
+
+  auto leave_async_mode() -> bool;
+
+  void output_silence(const uint& n_samples) const;
+
+  // Called by the filter once per graph cycle. The probe spans are only used when the probe is enabled.
+  void process_cycle(const uint64_t& position,
+                     std::span<float>& left_in,
+                     std::span<float>& right_in,
+                     std::span<float>& left_out,
+                     std::span<float>& right_out,
+                     std::span<float>& probe_left,
+                     std::span<float>& probe_right);
+
   virtual auto get_latency_seconds() -> float;
 
+  // Voice activity flag written by a noise reduction placed before this plugin. nullptr when there is none.
+  void set_voice_activity(std::atomic<bool>* flag);
+
+  /*
+    In the asynchronous mode process() runs in a worker thread and the filter outputs the result of the previous graph
+    cycle. A slow block then delays only this plugin instead of making the whole graph miss its deadline. The price is
+    exactly one quantum of extra latency.
+  */
+
+  void set_async(const bool& state);
+
+  // The quantum added by the asynchronous mode. It is already included in the latency reported to PipeWire.
+  [[nodiscard]] auto get_async_latency_seconds() const -> float;
+
   sigc::signal<void(const float, const float)> input_level;
   sigc::signal<void(const float, const float)> output_level;
   sigc::signal<void()> latency;
@@ -151,13 +194,25 @@ class PluginBase {
 
   uint n_ports = 4U;
 
-  float input_gain = 1.0F;
+  float input_gain = 1.0F;  // copies taken by the realtime thread like bypass
   float output_gain = 1.0F;
 
+  struct CommonParameters {
+    bool bypass = false;
+
+    float input_gain = 1.0F;
+
+    float output_gain = 1.0F;
+  };
+
+  ParameterSet<CommonParameters> common_parameters;
+
   std::unique_ptr<lv2::Lv2Wrapper> lv2_wrapper;
 
   std::vector<gulong> gconnections;
 
+  std::atomic<std::atomic<bool>*> voice_activity = nullptr;
+
   void setup_input_output_gain();
 
   void initialize_listener();
@@ -171,11 +226,72 @@ class PluginBase {
 
   static void apply_gain(std::span<float>& left, std::span<float>& right, const float& gain);
 
+  /*
+    Outputs silence and returns true when the voice activity detector says there is no speech. Heavy plugins call it
+    at the beginning of process() so that they do not waste cpu on the pauses of a voice chain. The block where the
+    voice stops is still processed, so that fade_without_voice() can fade it out.
+  */
+
+  auto skip_without_voice(std::span<float>& left_in,
+                          std::span<float>& right_in,
+                          std::span<float>& left_out,
+                          std::span<float>& right_out) -> bool;
+
+  // Called at the end of process() by the plugins using skip_without_voice(). It ramps the gain over one block.
+  void fade_without_voice(std::span<float>& left_out, std::span<float>& right_out);
+
   void update_filter_params();
 
+  /*
+    The gsettings handlers only edit the drafts. They are published in an idle callback that runs before the main loop
+    goes back to sleep. So all the keys changed in the same iteration, like the ones written by a preset or by a reset,
+    reach the realtime thread in the same block.
+  */
+
+  void schedule_parameters_update();
+
+  // Plugins with their own parameter sets publish them here before calling the base implementation
+  virtual void publish_parameters();
+
+  /*
+    Joins the worker of the asynchronous mode. Blocks still queued are discarded and the one being processed is waited
+    for. It must only be called when the filter is not running.
+  */
+
+  void stop_async();
+
  private:
+  guint publish_source_id = 0U;
+
+  class AsyncWorker;
+
   uint node_id = 0U;
 
+  std::atomic<bool> async_requested = false;
+
+  bool async_active = false;  // only used in the realtime thread
+
+  std::atomic<float> async_latency = 0.0F;  // seconds
+
+  bool voice_present = true;  // only used in the thread running process()
+
+  float voice_gain = 1.0F;
+
+  std::unique_ptr<AsyncWorker> async_worker;
+
+  // Returns false while the worker is busy with a block of the mode being left
+  auto update_async_mode() -> bool;
+
+  void notify_async_latency();
+
+  void run_process(const uint64_t& position,
+                   std::span<float>& left_in,
+                   std::span<float>& right_in,
+                   std::span<float>& left_out,
+                   std::span<float>& right_out,
+                   std::span<float>& probe_left,
+                   std::span<float>& probe_right);
+
   float input_peak_left = util::minimum_linear_level, input_peak_right = util::minimum_linear_level;
   float output_peak_left = util::minimum_linear_level, output_peak_right = util::minimum_linear_level;
 };
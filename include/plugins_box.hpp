@@ -38,6 +38,7 @@
 #include "level_meter_ui.hpp"
 #include "limiter_ui.hpp"
 #include "loudness_ui.hpp"
+#include "lv2_plugin_ui.hpp"
 #include "maximizer_ui.hpp"
 #include "multiband_compressor_ui.hpp"
 #include "multiband_gate_ui.hpp"
@@ -45,6 +45,7 @@
 #include "level_meter_preset.hpp"
 #include "limiter_preset.hpp"
 #include "loudness_preset.hpp"
+#include "lv2_plugin_preset.hpp"
 #include "maximizer_preset.hpp"
 #include "multiband_compressor_preset.hpp"
 #include "multiband_gate_preset.hpp"
@@ -149,6 +150,11 @@ class PresetsManager {
 
   void notify_error(const PresetError& preset_error, const std::string& plugin_name = "");
 
+  // Returns false and writes nothing when the list did not change
+  static auto update_string_list(GSettings* settings, const char* key, const std::vector<std::string>& list) -> bool;
+
+  void update_plugins_order(GSettings* effects_settings, const std::vector<std::string>& plugins);
+
   static auto create_wrapper(const PresetType& preset_type, std::string_view filter_name)
       -> std::optional<std::unique_ptr<PluginPresetBase>>;
 };
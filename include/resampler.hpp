@@ -26,27 +26,29 @@
 
 class Resampler {
  public:
-  Resampler(const int& input_rate, const int& output_rate);
+  enum class Quality { fastest, medium, best };
+
+  Resampler(const int& input_rate,
+            const int& output_rate,
+            const int& n_channels = 1,
+            const Quality& quality = Quality::fastest);
   Resampler(const Resampler&) = delete;
   auto operator=(const Resampler&) -> Resampler& = delete;
   Resampler(const Resampler&&) = delete;
   auto operator=(const Resampler&&) -> Resampler& = delete;
   ~Resampler();
 
+  // Single channel resampling that allocates its output. Meant for impulse responses and other offline work.
   template <typename T>
   auto process(const T& input, const bool& end_of_input) -> std::vector<float> {
-    output.resize(std::ceil(1.5F * resample_ratio * input.size()));
+    output.resize(get_max_output_frames(input.size()));
 
-    // The number of frames of data pointed to by data_in
-    src_data.input_frames = input.size();
+    src_data.input_frames = static_cast<long>(input.size());
 
-    // A pointer to the input data samples
     src_data.data_in = input.data();
 
-    // Maximum number of frames pointed to by data_out
     src_data.output_frames = static_cast<long>(output.size());
 
-    // A pointer to the output data samples
     src_data.data_out = output.data();
 
     // Equal to output_sample_rate / input_sample_rate
@@ -62,12 +64,30 @@ class Resampler {
     return output;
   }
 
+  /*
+    Realtime safe resampling. Both spans hold n_channels interleaved samples per frame and the output must have room
+    for get_max_output_frames(input frames). Returns the number of frames written to the output.
+  */
+
+  auto process(std::span<const float> input, std::span<float> output) -> size_t;
+
+  [[nodiscard]] auto get_max_output_frames(const size_t& input_frames) const -> size_t;
+
+  // Group delay of the converter in output frames. It is measured in the constructor.
+  [[nodiscard]] auto get_delay_frames() const -> size_t;
+
  private:
-  float resample_ratio = 1.0F;
+  int channels = 1;
+
+  size_t delay_frames = 0U;
+
+  double resample_ratio = 1.0;
 
   SRC_STATE* src_state = nullptr;
 
   SRC_DATA src_data{};
 
   std::vector<float> output;
+
+  void measure_delay(const int& converter);
 };
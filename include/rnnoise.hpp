@@ -45,14 +45,21 @@ class RNNoise : public PluginBase {
 
   auto get_latency_seconds() -> float override;
 
+  // Where the gate decision is published for the plugins placed after this one
+  void set_voice_activity_output(std::atomic<bool>* flag);
+
 #ifndef ENABLE_RNNOISE
   bool package_installed = false;
 #endif
 
   bool standard_model = true;
 
+  enum class ChannelMode { independent, linked, mono_sum };
+
   sigc::signal<void(const bool load_error)> model_changed;
 
+  sigc::signal<void(const float)> voice_probability;  // smoothed, from 0 to 1
+
  private:
   bool resample = false;
   bool notify_latency = false;
@@ -62,16 +69,56 @@ class RNNoise : public PluginBase {
   uint blocksize = 480U;
   uint rnnoise_rate = 48000U;
   uint latency_n_frames = 0U;
+  uint resampler_delay_frames = 0U;  // both conversion stages, in frames of the plugin rate
 
   const float inv_short_max = 1.0F / (SHRT_MAX + 1);
 
+  static constexpr float vad_release = 0.18F;  // 1 - exp(-10 ms / 50 ms)
+
+  bool vad_gate = false;
+  bool voice_detected = true;
+
+  uint vad_hangover_blocks = 0U;
+  uint vad_hangover_count = 0U;
+
+  float vad_threshold = 0.5F;
+  float vad_probability = 0.0F;
+  float gate_gain = 1.0F;
+
+  std::atomic<bool>* voice_activity_output = nullptr;
+
+  uint64_t voice_history = 0U;  // one bit per block, the newest is the lowest
+
   std::deque<float> deque_out_L, deque_out_R;
 
-  std::vector<float> data_L, data_R;
+  float linked_gain = 1.0F;
+
+  ChannelMode channel_mode = ChannelMode::independent;
+
+  std::vector<float> data_L, data_R, data_mid;
   std::vector<float> resampled_data_L, resampled_data_R;
 
-  std::unique_ptr<Resampler> resampler_inL, resampler_outL;
-  std::unique_ptr<Resampler> resampler_inR, resampler_outR;
+  // In the linked mode the gain computed from the denoised mid signal is applied to the previous block because that
+  // is the one rnnoise has just output.
+
+  std::vector<float> delayed_L, delayed_R, delayed_mid;
+
+  // scratch buffers sized in setup() so that the realtime thread does not allocate memory
+
+  std::vector<float> interleaved_in, resampled_in, resampled_inL, resampled_inR;
+  std::vector<float> interleaved_out, resampled_out;
+
+  std::unique_ptr<Resampler> resampler_in, resampler_out;
+
+  static auto parse_channel_mode_key(const std::string& key) -> ChannelMode;
+
+  void reset_linked_state();
+
+  void set_vad_hangover(const int& milliseconds);
+
+  void update_voice_activity(const float& probability);
+
+  void publish_voice_activity(const bool& active);
 
 #ifdef ENABLE_RNNOISE
 
@@ -83,44 +130,25 @@ class RNNoise : public PluginBase {
 
   void free_rnnoise();
 
+  void denoise_block();
+
+  auto denoise_block_linked() -> float;
+
   template <typename T1, typename T2>
   void remove_noise(const T1& left_in, const T1& right_in, T2& out_L, T2& out_R) {
-    for (const auto& v : left_in) {
-      data_L.push_back(v);
+    for (size_t n = 0U; n < left_in.size(); n++) {
+      data_L.push_back(left_in[n]);
+      data_R.push_back(right_in[n]);
 
       if (data_L.size() == blocksize) {
-        if (state_left != nullptr) {
-          std::ranges::for_each(data_L, [](auto& v) { v *= static_cast<float>(SHRT_MAX + 1); });
-
-          rnnoise_process_frame(state_left, data_L.data(), data_L.data());
+        denoise_block();
 
-          std::ranges::for_each(data_L, [&](auto& v) { v *= inv_short_max; });
-        }
-
-        for (const auto& v : data_L) {
-          out_L.push_back(v);
+        for (uint m = 0U; m < blocksize; m++) {
+          out_L.push_back(data_L[m]);
+          out_R.push_back(data_R[m]);
         }
 
         data_L.resize(0U);
-      }
-    }
-
-    for (const auto& v : right_in) {
-      data_R.push_back(v);
-
-      if (data_R.size() == blocksize) {
-        if (state_right != nullptr) {
-          std::ranges::for_each(data_R, [](auto& v) { v *= static_cast<float>(SHRT_MAX + 1); });
-
-          rnnoise_process_frame(state_right, data_R.data(), data_R.data());
-
-          std::ranges::for_each(data_R, [&](auto& v) { v *= inv_short_max; });
-        }
-
-        for (const auto& v : data_R) {
-          out_R.push_back(v);
-        }
-
         data_R.resize(0U);
       }
     }
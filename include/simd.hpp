@@ -0,0 +1,64 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+/*
+  Vectorized versions of the per sample loops used in the realtime thread. On x86_64 each function is compiled for
+  AVX-512, AVX2 and the SSE2 baseline and the dynamic loader picks the best one for the cpu when the program starts.
+  On ARM the baseline already has NEON.
+
+  Input and output spans must have the same number of frames. Processing in place is allowed whenever the input and
+  output types are the same.
+*/
+
+namespace simd {
+
+// Only used for logging
+auto instruction_set() -> std::string;
+
+void scale(std::span<float> data, const float& gain);
+
+auto max(std::span<const float> data) -> float;
+
+// output[n] = gain * (a[n] + b[n])
+void mix(std::span<const float> a, std::span<const float> b, const float& gain, std::span<float> output);
+
+void multiply(std::span<const float> a, std::span<const float> b, std::span<float> output);
+
+void interleave(std::span<const float> left, std::span<const float> right, std::span<float> output);
+
+void deinterleave(std::span<const float> input, std::span<float> left, std::span<float> right);
+
+// output[2n] = left[n] * window[n] and output[2n + 1] = right[n] * window[n]
+void window_and_interleave(std::span<const float> left,
+                           std::span<const float> right,
+                           std::span<const float> window,
+                           std::span<float> output);
+
+// The float values are multiplied by 32768 and saturated to the int16 range
+void float_to_int16(std::span<const float> input, std::span<int16_t> output);
+
+void int16_to_float(std::span<const int16_t> input, std::span<float> output);
+
+}  // namespace simd
@@ -20,7 +20,10 @@
 #pragma once
 
 #include <fftw3.h>
+#include <atomic>
+#include <condition_variable>
 #include <numbers>
+#include <thread>
 #include "plugin_base.hpp"
 
 class Spectrum : public PluginBase {
@@ -35,8 +38,6 @@ class Spectrum : public PluginBase {
   auto operator=(const Spectrum&&) -> Spectrum& = delete;
   ~Spectrum() override;
 
-  void setup() override;
-
   void process(std::span<float>& left_in,
                std::span<float>& right_in,
                std::span<float>& left_out,
@@ -44,19 +45,64 @@ class Spectrum : public PluginBase {
 
   auto get_latency_seconds() -> float override;
 
-  sigc::signal<void(uint, uint, std::vector<double>)> power;  // rate, nbands, magnitudes
+  enum class Mode { mono, left_right, mid_side, all };
+
+  sigc::signal<void(uint, uint, const std::vector<std::vector<double>>&)> power;  // rate, nbands, magnitudes
 
  private:
   bool fftw_ready = false;
 
+  bool worker_quit = false;
+
   fftwf_plan plan = nullptr;
 
+  fftwf_complex* complex_input = nullptr;
   fftwf_complex* complex_output = nullptr;
 
-  std::vector<float> real_input;
-  std::vector<double> output;
+  std::vector<float> window;
+
+  /*
+    One magnitude vector for each trace of the current mode. Mono: mid. Left/Right: left and right. Mid/Side: mid and
+    side. All: left, right, mid and side.
+  */
+
+  std::vector<std::vector<double>> output;
+  std::vector<std::vector<double>> ui_output;
+
+  uint fft_size = 8192U;
+
+  float overlap = 0.5F;
+
+  Mode mode = Mode::mono;
+
+  /*
+    The audio thread only writes the input signals in these ring buffers. Their size is twice the largest fft size so
+    the worker can copy a full fft frame while the audio thread keeps writing.
+  */
+
+  static constexpr uint max_fft_size = 16384U;
+
+  static constexpr uint ring_size = 2U * max_fft_size;
+
+  std::vector<float> ring_buffer_L, ring_buffer_R;
+
+  std::atomic<uint64_t> ring_position = 0U;
+
+  uint64_t last_fft_position = 0U;
+
+  std::condition_variable worker_cv;
+
+  std::thread worker;
+
+  void init_fftw(const uint& size);
+
+  void set_overlap(const int& percentage);
+
+  void set_mode(const Mode& value);
+
+  static auto parse_mode_key(const std::string& key) -> Mode;
 
-  uint n_bands = 8192U;
+  void worker_loop();
 
-  std::deque<float> deque_in_mono;
+  void calculate_spectrum();
 };
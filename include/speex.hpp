@@ -41,20 +41,48 @@ class Speex : public PluginBase {
 
   auto get_latency_seconds() -> float override;
 
+  enum class ChannelMode { independent, mono_sum };
+
  private:
   bool speex_ready = false;
+  bool notify_latency = false;
 
   int enable_denoise = 0, noise_suppression = -15, enable_agc = 0, enable_vad = 0, vad_probability_start = 95,
       vad_probability_continue = 90, enable_dereverb = 0;
 
   uint latency_n_frames = 0U;
 
-  const float inv_short_max = 1.0F / (SHRT_MAX + 1);
+  uint frame_duration = 20U;  // milliseconds
+  uint frame_size = 0U;
+  uint frame_position = 0U;
+
+  ChannelMode channel_mode = ChannelMode::independent;
 
   std::vector<spx_int16_t> data_L, data_R;
 
+  std::vector<float> frame_L, frame_R;
+
+  /*
+    The preprocessor always works on frames of 10 or 20 ms whatever the quantum is. Its output goes to this ring
+    buffer and we read one quantum from it in each cycle.
+  */
+
+  std::vector<float> ring_L, ring_R;
+
+  size_t ring_read = 0U;
+  size_t ring_count = 0U;
+
   SpeexPreprocessState *state_left = nullptr, *state_right = nullptr;
 
-  void free_speex();
+  static auto parse_channel_mode_key(const std::string& key) -> ChannelMode;
+
+  static auto parse_frame_size_key(const std::string& key) -> uint;
+
+  void init_speex();
 
+  void configure_state(SpeexPreprocessState* state);
+
+  void process_frame();
+
+  void free_speex();
 };
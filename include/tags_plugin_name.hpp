@@ -32,12 +32,12 @@ inline constexpr auto bs2b = "bs2b";
 
 inline constexpr auto calf = "Calf Studio Gear";
 
-inline constexpr auto ebur128 = "libebur128";
-
 inline constexpr auto ee = "Easy Effects";
 
 inline constexpr auto lsp = "Linux Studio Plugins";
 
+inline constexpr auto lv2 = "LV2";
+
 inline constexpr auto mda = "MDA";
 
 inline constexpr auto rnnoise = "RNNoise";
@@ -90,6 +90,8 @@ inline constexpr auto limiter = "limiter";
 
 inline constexpr auto loudness = "loudness";
 
+inline constexpr auto lv2_plugin = "lv2_plugin";
+
 inline constexpr auto maximizer = "maximizer";
 
 inline constexpr auto multiband_compressor = "multiband_compressor";
@@ -107,12 +109,12 @@ inline constexpr auto rnnoise = "rnnoise";
 inline constexpr auto stereo_tools = "stereo_tools";
 
 inline constexpr auto list =
-    std::to_array({autogain,       bass_enhancer, bass_loudness, compressor, convolver,
-                   crossfeed,      crystalizer,   deesser,       delay,      echo_canceller,
-                   equalizer,      exciter,       expander,      filter,     gate,
-                   level_meter,    limiter,       loudness,      maximizer,  multiband_compressor,
-                   multiband_gate, pitch,         reverb,        rnnoise,    speex,
-                   stereo_tools});
+    std::to_array({autogain,             bass_enhancer,  bass_loudness, compressor, convolver,
+                   crossfeed,            crystalizer,    deesser,       delay,      echo_canceller,
+                   equalizer,            exciter,        expander,      filter,     gate,
+                   level_meter,          limiter,        loudness,      lv2_plugin, maximizer,
+                   multiband_compressor, multiband_gate, pitch,         reverb,     rnnoise,
+                   speex,                stereo_tools});
 
 auto get_translated() -> std::map<std::string, std::string>;
 
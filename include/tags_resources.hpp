@@ -89,6 +89,8 @@ inline constexpr auto limiter_ui = "/com/github/wwmm/easyeffects/ui/limiter.ui";
 
 inline constexpr auto loudness_ui = "/com/github/wwmm/easyeffects/ui/loudness.ui";
 
+inline constexpr auto lv2_plugin_ui = "/com/github/wwmm/easyeffects/ui/lv2_plugin.ui";
+
 inline constexpr auto maximizer_ui = "/com/github/wwmm/easyeffects/ui/maximizer.ui";
 
 inline constexpr auto multiband_compressor_ui = "/com/github/wwmm/easyeffects/ui/multiband_compressor.ui";
@@ -209,6 +209,16 @@ inline constexpr auto output_path = "/com/github/wwmm/easyeffects/streamoutputs/
 
 }  // namespace tags::schema::loudness
 
+namespace tags::schema::lv2_plugin {
+
+inline constexpr auto id = "com.github.wwmm.easyeffects.lv2plugin";
+
+inline constexpr auto input_path = "/com/github/wwmm/easyeffects/streaminputs/lv2plugin/";
+
+inline constexpr auto output_path = "/com/github/wwmm/easyeffects/streamoutputs/lv2plugin/";
+
+}  // namespace tags::schema::lv2_plugin
+
 namespace tags::schema::maximizer {
 
 inline constexpr auto id = "com.github.wwmm.easyeffects.maximizer";
@@ -55,6 +55,10 @@ void on_startup(GApplication* gapp) {
 
   auto* self = EE_APP(gapp);
 
+  // The LV2 bundles are parsed while the rest of the application is initialized
+
+  lv2::World::get().load_async();
+
   self->data = new Data();
 
   self->sie_settings = g_settings_new(tags::schema::id_input);
@@ -233,6 +237,8 @@ void on_startup(GApplication* gapp) {
       util::debug("Cannot check the current PipeWire version against the minimum supported.");
       break;
   }
+
+  util::debug("using the " + simd::instruction_set() + " version of the vectorized functions");
 }
 
 void application_class_init(ApplicationClass* klass) {
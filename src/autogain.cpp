@@ -23,36 +23,40 @@ AutoGain::AutoGain(const std::string& tag,
                    const std::string& schema,
                    const std::string& schema_path,
                    PipeManager* pipe_manager)
-    : PluginBase(tag, tags::plugin_name::autogain, tags::plugin_package::ebur128, schema, schema_path, pipe_manager),
-      target(g_settings_get_double(settings, "target")),
-      silence_threshold(g_settings_get_double(settings, "silence-threshold")) {
-  reference = parse_reference_key(util::gsettings_get_string(settings, "reference"));
+    : PluginBase(tag, tags::plugin_name::autogain, tags::plugin_package::ee, schema, schema_path, pipe_manager) {
+  parameters.draft.target = g_settings_get_double(settings, "target");
+  parameters.draft.silence_threshold = g_settings_get_double(settings, "silence-threshold");
+  parameters.draft.reference = parse_reference_key(util::gsettings_get_string(settings, "reference"));
+
+  parameters.publish();
 
   gconnections.push_back(g_signal_connect(settings, "changed::target",
                                           G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
                                             auto* self = static_cast<AutoGain*>(user_data);
 
-                                            self->target = g_settings_get_double(settings, key);
+                                            self->parameters.draft.target = g_settings_get_double(settings, key);
+
+                                            self->schedule_parameters_update();
                                           }),
                                           this));
 
-  gconnections.push_back(g_signal_connect(settings, "changed::silence-threshold",
-                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                                            auto* self = static_cast<AutoGain*>(user_data);
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::silence-threshold", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<AutoGain*>(user_data);
 
-                                            self->silence_threshold = g_settings_get_double(settings, key);
-                                          }),
-                                          this));
+        self->parameters.draft.silence_threshold = g_settings_get_double(settings, key);
 
-  gconnections.push_back(g_signal_connect(settings, "changed::maximum-history",
-                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                                            auto* self = static_cast<AutoGain*>(user_data);
+        self->schedule_parameters_update();
+      }),
+      this));
 
-                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::maximum-history", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<AutoGain*>(user_data);
 
-                                            self->set_maximum_history(g_settings_get_int(settings, key));
-                                          }),
-                                          this));
+        self->analyzer.set_maximum_history(static_cast<uint>(g_settings_get_int(settings, key)));
+      }),
+      this));
 
   gconnections.push_back(g_signal_connect(
       settings, "changed::reset-history", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
@@ -61,15 +65,15 @@ AutoGain::AutoGain(const std::string& tag,
         self->mythreads.emplace_back([self]() {  // Using emplace_back here makes sense
           self->data_mutex.lock();
 
-          self->ebur128_ready = false;
+          self->analyzer_ready = false;
 
           self->data_mutex.unlock();
 
-          auto status = self->init_ebur128();
+          auto status = self->init_analyzer();
 
           self->data_mutex.lock();
 
-          self->ebur128_ready = status;
+          self->analyzer_ready = status;
 
           self->data_mutex.unlock();
         });
@@ -80,7 +84,9 @@ AutoGain::AutoGain(const std::string& tag,
       settings, "changed::reference", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
         auto* self = static_cast<AutoGain*>(user_data);
 
-        self->reference = parse_reference_key(util::gsettings_get_string(settings, key));
+        self->parameters.draft.reference = parse_reference_key(util::gsettings_get_string(settings, key));
+
+        self->schedule_parameters_update();
       }),
       this));
 
@@ -98,36 +104,25 @@ AutoGain::~AutoGain() {
 
   mythreads.clear();
 
-  std::scoped_lock<std::mutex> lock(data_mutex);
-
-  if (ebur_state != nullptr) {
-    ebur128_destroy(&ebur_state);
-  }
-
   util::debug(log_tag + name + " destroyed");
 }
 
-auto AutoGain::init_ebur128() -> bool {
+auto AutoGain::init_analyzer() -> bool {
   if (n_samples == 0 || rate == 0) {
     return false;
   }
 
   internal_output_gain = 1.0;
 
-  if (ebur_state != nullptr) {
-    ebur128_destroy(&ebur_state);
-
-    ebur_state = nullptr;
-  }
-
-  ebur_state = ebur128_init(2U, rate, EBUR128_MODE_S | EBUR128_MODE_I | EBUR128_MODE_LRA | EBUR128_MODE_SAMPLE_PEAK);
+  analyzer.init(rate, false, static_cast<uint>(g_settings_get_int(settings, "maximum-history")));
 
-  ebur128_set_channel(ebur_state, 0U, EBUR128_LEFT);
-  ebur128_set_channel(ebur_state, 1U, EBUR128_RIGHT);
+  return analyzer.is_ready();
+}
 
-  set_maximum_history(g_settings_get_int(settings, "maximum-history"));
+void AutoGain::publish_parameters() {
+  parameters.publish();
 
-  return ebur_state != nullptr;
+  PluginBase::publish_parameters();
 }
 
 auto AutoGain::parse_reference_key(const std::string& key) -> Reference {
@@ -158,30 +153,22 @@ auto AutoGain::parse_reference_key(const std::string& key) -> Reference {
   return Reference::geometric_mean_msi;
 }
 
-void AutoGain::set_maximum_history(const int& seconds) {
-  if (ebur_state == nullptr) {
-    return;
-  }
-
-  // The value given to ebur128_set_max_history must be in milliseconds
+void AutoGain::set_loudness_sources(const std::vector<std::shared_ptr<LoudnessAnalyzer>>& sources) {
+  std::scoped_lock<std::mutex> lock(data_mutex);
 
-  ebur128_set_max_history(ebur_state, static_cast<ulong>(seconds) * 1000UL);
+  loudness_sources = sources;
 }
 
 void AutoGain::setup() {
-  if (2U * static_cast<size_t>(n_samples) != data.size()) {
-    data.resize(static_cast<size_t>(n_samples) * 2U);
-  }
-
   if (rate != old_rate) {
     data_mutex.lock();
 
-    ebur128_ready = false;
+    analyzer_ready = false;
 
     data_mutex.unlock();
 
     mythreads.emplace_back([this]() {  // Using emplace_back here makes sense
-      if (ebur128_ready) {
+      if (analyzer_ready) {
         return;
       }
 
@@ -189,11 +176,11 @@ void AutoGain::setup() {
 
       old_rate = rate;
 
-      status = init_ebur128();
+      status = init_analyzer();
 
       data_mutex.lock();
 
-      ebur128_ready = status;
+      analyzer_ready = status;
 
       data_mutex.unlock();
     });
@@ -206,7 +193,9 @@ void AutoGain::process(std::span<float>& left_in,
                        std::span<float>& right_out) {
   std::scoped_lock<std::mutex> lock(data_mutex);
 
-  if (bypass || !ebur128_ready) {
+  const auto& p = parameters.read();
+
+  if (bypass || !analyzer_ready) {
     std::copy(left_in.begin(), left_in.end(), left_out.begin());
     std::copy(right_in.begin(), right_in.end(), right_out.begin());
 
@@ -217,31 +206,37 @@ void AutoGain::process(std::span<float>& left_in,
     apply_gain(left_in, right_in, input_gain);
   }
 
-  for (size_t n = 0U; n < n_samples; n++) {
-    data[2U * n] = left_in[n];
-    data[2U * n + 1U] = right_in[n];
-  }
+  // When a level meter placed before us is seeing the same signal its analysis is reused
 
-  ebur128_add_frames_float(ebur_state, data.data(), n_samples);
+  auto shared_analysis = false;
 
-  auto failed = false;
+  for (const auto& source : loudness_sources) {
+    if (analyzer.follow(*source, left_in, right_in, clock_position)) {
+      shared_analysis = true;
 
-  if (EBUR128_SUCCESS != ebur128_loudness_momentary(ebur_state, &momentary)) {
-    failed = true;
+      break;
+    }
   }
 
-  if (EBUR128_SUCCESS != ebur128_loudness_shortterm(ebur_state, &shortterm)) {
-    failed = true;
+  if (!shared_analysis) {
+    analyzer.process(left_in, right_in, clock_position);
   }
 
-  if (EBUR128_SUCCESS != ebur128_loudness_global(ebur_state, &global)) {
-    failed = true;
-  }
+  /*
+    All queries are constant time. The integrated loudness, the relative threshold and the loudness range are only
+    recalculated when a new gating block is closed. That happens every 100 ms.
+  */
+
+  momentary = analyzer.momentary();
+  shortterm = analyzer.shortterm();
+  global = analyzer.integrated();
+  relative = analyzer.relative_threshold();
+  range = analyzer.range();
 
   if (std::isinf(momentary) || std::isnan(momentary)) {
     /*
       Assuming zero so that the output gain is negative. This should avoid undesirably high amplification in case
-      a bad resutla comes from libebur128
+      of a bad result
     */
 
     momentary = 0.0;
@@ -267,90 +262,72 @@ void AutoGain::process(std::span<float>& left_in,
     global = momentary;
   }
 
-  if (EBUR128_SUCCESS != ebur128_relative_threshold(ebur_state, &relative)) {
-    failed = true;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_loudness_range(ebur_state, &range)) {
-    failed = true;
-  }
+  if (momentary > p.silence_threshold) {
+    const double peak_L = analyzer.previous_sample_peak(0U);
+    const double peak_R = analyzer.previous_sample_peak(1U);
 
-  if (momentary > silence_threshold && !failed) {
-    double peak_L = 0.0;
-    double peak_R = 0.0;
+    switch (p.reference) {
+      case Reference::momentary: {
+        loudness = momentary;
 
-    if (EBUR128_SUCCESS != ebur128_prev_sample_peak(ebur_state, 0U, &peak_L)) {
-      failed = true;
-    }
-
-    if (EBUR128_SUCCESS != ebur128_prev_sample_peak(ebur_state, 1U, &peak_R)) {
-      failed = true;
-    }
-
-    if (!failed) {
-      switch (reference) {
-        case Reference::momentary: {
-          loudness = momentary;
+        break;
+      }
+      case Reference::shortterm: {
+        loudness = shortterm;
 
-          break;
-        }
-        case Reference::shortterm: {
-          loudness = shortterm;
+        break;
+      }
+      case Reference::integrated: {
+        loudness = global;
 
-          break;
-        }
-        case Reference::integrated: {
-          loudness = global;
+        break;
+      }
+      case Reference::geometric_mean_msi: {
+        loudness = std::cbrt(momentary * shortterm * global);
 
-          break;
-        }
-        case Reference::geometric_mean_msi: {
-          loudness = std::cbrt(momentary * shortterm * global);
+        break;
+      }
+      case Reference::geometric_mean_ms: {
+        loudness = std::sqrt(std::fabs(momentary * shortterm));
 
-          break;
+        if (momentary < 0 && shortterm < 0) {
+          loudness *= -1;
         }
-        case Reference::geometric_mean_ms: {
-          loudness = std::sqrt(std::fabs(momentary * shortterm));
 
-          if (momentary < 0 && shortterm < 0) {
-            loudness *= -1;
-          }
+        break;
+      }
+      case Reference::geometric_mean_mi: {
+        loudness = std::sqrt(std::fabs(momentary * global));
 
-          break;
+        if (momentary < 0 && global < 0) {
+          loudness *= -1;
         }
-        case Reference::geometric_mean_mi: {
-          loudness = std::sqrt(std::fabs(momentary * global));
 
-          if (momentary < 0 && global < 0) {
-            loudness *= -1;
-          }
+        break;
+      }
+      case Reference::geometric_mean_si: {
+        loudness = std::sqrt(std::fabs(shortterm * global));
 
-          break;
+        if (shortterm < 0 && global < 0) {
+          loudness *= -1;
         }
-        case Reference::geometric_mean_si: {
-          loudness = std::sqrt(std::fabs(shortterm * global));
-
-          if (shortterm < 0 && global < 0) {
-            loudness *= -1;
-          }
 
-          break;
-        }
+        break;
       }
+    }
 
-      const double diff = target - loudness;
+    const double diff = p.target - loudness;
 
-      // 10^(diff/20). The way below should be faster than using pow
-      const double gain = std::exp((diff / 20.0) * std::log(10.0));
+    // 10^(diff/20). The way below should be faster than using pow
+    const double gain = std::exp((diff / 20.0) * std::log(10.0));
 
-      const double peak = (peak_L > peak_R) ? peak_L : peak_R;
+    const double peak = (peak_L > peak_R) ? peak_L : peak_R;
 
-      const auto db_peak = util::linear_to_db(peak);
+    const auto db_peak = util::linear_to_db(peak);
 
-      if (db_peak > util::minimum_db_level) {
-        if (gain * peak < 1.0) {
-          internal_output_gain = gain;
-        }
+    if (db_peak > util::minimum_db_level) {
+      if (gain * peak < 1.0) {
+        internal_output_gain = gain;
       }
     }
   }
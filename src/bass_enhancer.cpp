@@ -46,6 +46,8 @@ BassEnhancer::BassEnhancer(const std::string& tag,
 
   lv2_wrapper->bind_key_bool<"listen", "listen">(settings);
 
+  harmonics_port = lv2_wrapper->find_control_port("meter_drive");
+
   setup_input_output_gain();
 }
 
@@ -97,7 +99,7 @@ void BassEnhancer::process(std::span<float>& left_in,
     if (send_notifications) {
       // harmonics needed as double for levelbar widget ui, so we convert it here
 
-      harmonics_port_value = static_cast<double>(lv2_wrapper->get_control_port_value("meter_drive"));
+      harmonics_port_value = static_cast<double>(lv2_wrapper->get_control_port_value(harmonics_port));
 
       if (!post_messages) {
         return;
@@ -46,6 +46,12 @@ struct Data {
   std::string x_unit, y_unit;
 
   std::vector<double> y_axis, x_axis, x_axis_log, objects_x;
+
+  // traces drawn as lines over the main one. They share its y range.
+
+  std::vector<std::vector<double>> y_axis_traces;
+
+  std::vector<GdkRGBA> traces_colors;
 };
 
 struct _Chart {
@@ -210,6 +216,38 @@ void set_x_data(Chart* self, const std::vector<double>& x) {
   });
 }
 
+void normalize_y_data(Chart* self) {
+  self->data->y_min = std::ranges::min(self->data->y_axis);
+  self->data->y_max = std::ranges::max(self->data->y_axis);
+
+  for (const auto& trace : self->data->y_axis_traces) {
+    if (!trace.empty()) {
+      self->data->y_min = std::min(self->data->y_min, std::ranges::min(trace));
+      self->data->y_max = std::max(self->data->y_max, std::ranges::max(trace));
+    }
+  }
+
+  if (std::fabs(self->data->y_max - self->data->y_min) < 0.00001) {
+    std::ranges::fill(self->data->y_axis, 0.0);
+
+    for (auto& trace : self->data->y_axis_traces) {
+      std::ranges::fill(trace, 0.0);
+    }
+  } else {
+    // making each y value a number between 0 and 1
+
+    auto normalize = [&](auto& v) { v = (v - self->data->y_min) / (self->data->y_max - self->data->y_min); };
+
+    std::ranges::for_each(self->data->y_axis, normalize);
+
+    for (auto& trace : self->data->y_axis_traces) {
+      std::ranges::for_each(trace, normalize);
+    }
+  }
+
+  gtk_widget_queue_draw(GTK_WIDGET(self));
+}
+
 void set_y_data(Chart* self, const std::vector<double>& y) {
   if (self == nullptr || y.empty()) {
     return;
@@ -217,19 +255,35 @@ void set_y_data(Chart* self, const std::vector<double>& y) {
 
   self->data->y_axis = y;
 
-  self->data->y_min = std::ranges::min(y);
-  self->data->y_max = std::ranges::max(y);
+  self->data->y_axis_traces.clear();
 
-  if (std::fabs(self->data->y_max - self->data->y_min) < 0.00001) {
-    std::ranges::fill(self->data->y_axis, 0.0);
-  } else {
-    // making each y value a number between 0 and 1
+  normalize_y_data(self);
+}
+
+void set_y_data(Chart* self, const std::vector<std::vector<double>>& traces) {
+  if (self == nullptr || traces.empty() || traces.front().empty()) {
+    return;
+  }
+
+  // the first trace is drawn using the chart type. The others are drawn as lines over it.
+
+  self->data->y_axis = traces.front();
 
-    std::ranges::for_each(self->data->y_axis,
-                          [&](auto& v) { v = (v - self->data->y_min) / (self->data->y_max - self->data->y_min); });
+  self->data->y_axis_traces.resize(traces.size() - 1U);
+
+  for (size_t n = 1U; n < traces.size(); n++) {
+    self->data->y_axis_traces[n - 1U] = traces[n];
   }
 
-  gtk_widget_queue_draw(GTK_WIDGET(self));
+  normalize_y_data(self);
+}
+
+void set_traces_colors(Chart* self, const std::vector<GdkRGBA>& colors) {
+  if (self->data == nullptr) {
+    return;
+  }
+
+  self->data->traces_colors = colors;
 }
 
 void on_pointer_motion(GtkEventControllerMotion* controller, double xpos, double ypos, Chart* self) {
@@ -372,6 +426,36 @@ auto draw_x_labels(Chart* self, GtkSnapshot* snapshot, const int& width, const i
   return 0;
 }
 
+void draw_trace(Chart* self,
+                GtkSnapshot* snapshot,
+                const graphene_rect_t& widget_rectangle,
+                const std::vector<double>& y,
+                const GdkRGBA& color,
+                const double& usable_height,
+                const int& height) {
+  if (y.size() != self->data->objects_x.size() || y.size() < 2U) {
+    return;
+  }
+
+  auto* ctx = gtk_snapshot_append_cairo(snapshot, &widget_rectangle);
+
+  cairo_set_source_rgba(ctx, static_cast<double>(color.red), static_cast<double>(color.green),
+                        static_cast<double>(color.blue), static_cast<double>(color.alpha));
+
+  cairo_move_to(ctx, self->data->objects_x.front(),
+                self->data->margin * height + usable_height - y.front() * usable_height);
+
+  for (size_t n = 1U; n < y.size(); n++) {
+    cairo_line_to(ctx, self->data->objects_x[n], self->data->margin * height + usable_height - y[n] * usable_height);
+  }
+
+  cairo_set_line_width(ctx, self->data->line_width);
+
+  cairo_stroke(ctx);
+
+  cairo_destroy(ctx);
+}
+
 void snapshot(GtkWidget* widget, GtkSnapshot* snapshot) {
   auto* self = EE_CHART(widget);
 
@@ -433,6 +517,8 @@ void snapshot(GtkWidget* widget, GtkSnapshot* snapshot) {
 
     float radius = (self->data->rounded_corners) ? 5.0F : 0.0F;
 
+    const auto traces_height = usable_height;
+
     switch (self->data->chart_type) {
       case ChartType::bar: {
         double dw = width / static_cast<double>(n_points);
@@ -549,6 +635,12 @@ void snapshot(GtkWidget* widget, GtkSnapshot* snapshot) {
       }
     }
 
+    for (size_t n = 0U; n < self->data->y_axis_traces.size(); n++) {
+      const auto& color = (n < self->data->traces_colors.size()) ? self->data->traces_colors[n] : self->data->color;
+
+      draw_trace(self, snapshot, widget_rectangle, self->data->y_axis_traces[n], color, traces_height, height);
+    }
+
     if (gtk_event_controller_motion_contains_pointer(GTK_EVENT_CONTROLLER_MOTION(self->controller_motion)) != 0) {
       // We leave a withespace at the end to not stick the string at the window border.
       const auto msg = fmt::format(ui::get_user_locale(), "x = {0:.{1}Lf} {2} y = {3:.{4}Lf} {5} ", self->data->mouse_x,
@@ -101,6 +101,12 @@ Compressor::Compressor(const std::string& tag,
 
   lv2_wrapper->bind_key_double_db<"cwt", "wet", false>(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+  reduction_port = lv2_wrapper->find_control_port("rlm");
+  sidechain_port = lv2_wrapper->find_control_port("slm");
+  curve_port = lv2_wrapper->find_control_port("clm");
+  envelope_port = lv2_wrapper->find_control_port("elm");
+
   setup_input_output_gain();
 }
 
@@ -137,6 +143,10 @@ void Compressor::process(std::span<float>& left_in,
     return;
   }
 
+  if (skip_without_voice(left_in, right_in, left_out, right_out)) {
+    return;
+  }
+
   if (input_gain != 1.0F) {
     apply_gain(left_in, right_in, input_gain);
   }
@@ -148,11 +158,13 @@ void Compressor::process(std::span<float>& left_in,
     apply_gain(left_out, right_out, output_gain);
   }
 
+  fade_without_voice(left_out, right_out);
+
   /*
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -176,10 +188,10 @@ void Compressor::process(std::span<float>& left_in,
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
-      reduction_port_value = lv2_wrapper->get_control_port_value("rlm");
-      sidechain_port_value = lv2_wrapper->get_control_port_value("slm");
-      curve_port_value = lv2_wrapper->get_control_port_value("clm");
-      envelope_port_value = lv2_wrapper->get_control_port_value("elm");
+      reduction_port_value = lv2_wrapper->get_control_port_value(reduction_port);
+      sidechain_port_value = lv2_wrapper->get_control_port_value(sidechain_port);
+      curve_port_value = lv2_wrapper->get_control_port_value(curve_port);
+      envelope_port_value = lv2_wrapper->get_control_port_value(envelope_port);
 
       reduction.emit(reduction_port_value);
       sidechain.emit(sidechain_port_value);
@@ -164,6 +164,10 @@ void Convolver::process(std::span<float>& left_in,
     return;
   }
 
+  if (skip_without_voice(left_in, right_in, left_out, right_out)) {
+    return;
+  }
+
   if (input_gain != 1.0F) {
     apply_gain(left_in, right_in, input_gain);
   }
@@ -236,6 +240,8 @@ void Convolver::process(std::span<float>& left_in,
     apply_gain(left_out, right_out, output_gain);
   }
 
+  fade_without_voice(left_out, right_out);
+
   if (notify_latency) {
     latency_value = static_cast<float>(latency_n_frames) / static_cast<float>(rate);
 
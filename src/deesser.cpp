@@ -56,6 +56,9 @@ Deesser::Deesser(const std::string& tag,
 
   lv2_wrapper->bind_key_bool<"sc_listen", "sc-listen">(settings);
 
+  detected_port = lv2_wrapper->find_control_port("detected");
+  compression_port = lv2_wrapper->find_control_port("compression");
+
   setup_input_output_gain();
 }
 
@@ -107,8 +110,8 @@ void Deesser::process(std::span<float>& left_in,
     if (send_notifications) {
       // values needed as double for levelbars widget ui, so we convert them here
 
-      detected_port_value = static_cast<double>(lv2_wrapper->get_control_port_value("detected"));
-      compression_port_value = static_cast<double>(lv2_wrapper->get_control_port_value("compression"));
+      detected_port_value = static_cast<double>(lv2_wrapper->get_control_port_value(detected_port));
+      compression_port_value = static_cast<double>(lv2_wrapper->get_control_port_value(compression_port));
 
       detected.emit(detected_port_value);
       compression.emit(compression_port_value);
@@ -45,6 +45,8 @@ Delay::Delay(const std::string& tag,
   lv2_wrapper->bind_key_double_db<"wet_l", "wet-l", false>(settings);
   lv2_wrapper->bind_key_double_db<"wet_r", "wet-r", false>(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+
   setup_input_output_gain();
 }
 
@@ -94,7 +96,7 @@ void Delay::process(std::span<float>& left_in,
     This plugin gives the latency in number of samples
   */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
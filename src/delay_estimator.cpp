@@ -0,0 +1,232 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "delay_estimator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+constexpr auto worker_interval = std::chrono::milliseconds(250);
+
+// Mean square below -80 dBFS. There is nothing to correlate.
+constexpr double silence_energy = 1e-8;
+
+// How much the correlation peak has to stand out from the average correlation
+constexpr float min_peak_ratio = 10.0F;
+
+}  // namespace
+
+DelayEstimator::DelayEstimator() : ring_signal(ring_size, 0.0F), ring_reference(ring_size, 0.0F) {
+  /*
+    fftw planning is not thread safe. The plans are created here in the main thread and the worker only executes them.
+    Both signals go in the same complex fft. The signal is the real part and the reference the imaginary one.
+  */
+
+  complex_input = fftwf_alloc_complex(fft_size);
+  complex_output = fftwf_alloc_complex(fft_size);
+  cross_spectrum = fftwf_alloc_complex(fft_size / 2U + 1U);
+  correlation = fftwf_alloc_real(fft_size);
+
+  std::fill_n(&complex_input[0][0], 2U * fft_size, 0.0F);
+
+  forward_plan =
+      fftwf_plan_dft_1d(static_cast<int>(fft_size), complex_input, complex_output, FFTW_FORWARD, FFTW_ESTIMATE);
+
+  backward_plan = fftwf_plan_dft_c2r_1d(static_cast<int>(fft_size), cross_spectrum, correlation, FFTW_ESTIMATE);
+
+  worker = std::thread([this]() { worker_loop(); });
+}
+
+DelayEstimator::~DelayEstimator() {
+  worker_mutex.lock();
+
+  worker_quit = true;
+
+  worker_mutex.unlock();
+
+  worker_cv.notify_one();
+
+  worker.join();
+
+  fftwf_destroy_plan(forward_plan);
+  fftwf_destroy_plan(backward_plan);
+
+  fftwf_free(complex_input);
+  fftwf_free(complex_output);
+  fftwf_free(cross_spectrum);
+  fftwf_free(correlation);
+}
+
+void DelayEstimator::reset(const uint& sampling_rate, const uint& max_delay_samples) {
+  rate.store(sampling_rate, std::memory_order_relaxed);
+
+  max_lag.store(std::min(max_delay_samples, window_size - 1U), std::memory_order_relaxed);
+
+  delay.store(-1, std::memory_order_relaxed);
+
+  reset_requested.store(true, std::memory_order_relaxed);
+}
+
+void DelayEstimator::push(std::span<const float> signal, std::span<const float> reference) {
+  const auto position = ring_position.load(std::memory_order_relaxed);
+
+  const auto offset = static_cast<size_t>(position % ring_size);
+
+  const auto count = std::min(signal.size(), ring_size - offset);
+
+  std::copy(signal.begin(), signal.begin() + count, ring_signal.begin() + offset);
+  std::copy(reference.begin(), reference.begin() + count, ring_reference.begin() + offset);
+
+  std::copy(signal.begin() + count, signal.end(), ring_signal.begin());
+  std::copy(reference.begin() + count, reference.end(), ring_reference.begin());
+
+  ring_position.store(position + signal.size(), std::memory_order_release);
+}
+
+void DelayEstimator::worker_loop() {
+  std::unique_lock<std::mutex> lock(worker_mutex);
+
+  while (!worker_quit) {
+    worker_cv.wait_for(lock, worker_interval, [this]() { return worker_quit; });
+
+    if (worker_quit) {
+      break;
+    }
+
+    if (reset_requested.exchange(false)) {
+      candidate = -1;
+
+      last_position = ring_position.load(std::memory_order_acquire);
+    }
+
+    if (rate.load(std::memory_order_relaxed) == 0U || forward_plan == nullptr || backward_plan == nullptr) {
+      continue;
+    }
+
+    estimate();
+  }
+}
+
+void DelayEstimator::estimate() {
+  const auto position = ring_position.load(std::memory_order_acquire);
+
+  // a new window half overlapping the previous one
+
+  if (position - last_position < window_size / 2U || position < window_size) {
+    return;
+  }
+
+  last_position = position;
+
+  double signal_energy = 0.0;
+  double reference_energy = 0.0;
+
+  for (uint n = 0U; n < window_size; n++) {
+    const auto idx = static_cast<size_t>((position - window_size + n) % ring_size);
+
+    const auto s = ring_signal[idx];
+    const auto r = ring_reference[idx];
+
+    complex_input[n][0] = s;
+    complex_input[n][1] = r;
+
+    signal_energy += static_cast<double>(s * s);
+    reference_energy += static_cast<double>(r * r);
+  }
+
+  // if the audio thread overwrote part of the window while we were copying it we just wait for the next one
+
+  if (ring_position.load(std::memory_order_acquire) - position > ring_size - window_size) {
+    return;
+  }
+
+  if (signal_energy < silence_energy * window_size || reference_energy < silence_energy * window_size) {
+    return;
+  }
+
+  fftwf_execute(forward_plan);
+
+  /*
+    Signal[k] = (Z[k] + conj(Z[N - k])) / 2
+    Reference[k] = (Z[k] - conj(Z[N - k])) / 2i
+
+    The phase transform keeps only the phase of the cross spectrum. Its inverse transform has a sharp peak at the lag
+    between the signals whatever their spectra are.
+  */
+
+  for (uint k = 0U; k <= fft_size / 2U; k++) {
+    const auto& z = complex_output[k];
+    const auto& z_mirror = complex_output[(fft_size - k) % fft_size];
+
+    const float s_re = 0.5F * (z[0] + z_mirror[0]);
+    const float s_im = 0.5F * (z[1] - z_mirror[1]);
+
+    const float r_re = 0.5F * (z[1] + z_mirror[1]);
+    const float r_im = -0.5F * (z[0] - z_mirror[0]);
+
+    // Signal * conj(Reference)
+
+    const float g_re = s_re * r_re + s_im * r_im;
+    const float g_im = s_im * r_re - s_re * r_im;
+
+    const float magnitude = std::sqrt(g_re * g_re + g_im * g_im);
+
+    const float scale = (magnitude > 1e-20F) ? 1.0F / magnitude : 0.0F;
+
+    cross_spectrum[k][0] = g_re * scale;
+    cross_spectrum[k][1] = g_im * scale;
+  }
+
+  fftwf_execute(backward_plan);
+
+  // positive lags are the ones where the signal comes after the reference
+
+  const auto n_lags = max_lag.load(std::memory_order_relaxed) + 1U;
+
+  const auto lags = std::span<const float>(correlation, n_lags);
+
+  const auto peak = std::ranges::max_element(lags);
+
+  float mean = 0.0F;
+
+  for (const auto& v : lags) {
+    mean += std::fabs(v);
+  }
+
+  mean /= static_cast<float>(n_lags);
+
+  if (*peak < min_peak_ratio * mean) {
+    return;
+  }
+
+  const auto lag = static_cast<int>(std::distance(lags.begin(), peak));
+
+  // An estimate is only published after two consecutive windows agree within 1 ms
+
+  const auto tolerance = static_cast<int>(rate.load(std::memory_order_relaxed) / 1000U);
+
+  if (candidate >= 0 && std::abs(lag - candidate) <= tolerance) {
+    delay.store(lag, std::memory_order_relaxed);
+  }
+
+  candidate = lag;
+}
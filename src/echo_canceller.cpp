@@ -32,6 +32,54 @@ EchoCanceller::EchoCanceller(const std::string& tag,
                  true),
       residual_echo_suppression(g_settings_get_int(settings, "residual-echo-suppression")),
       near_end_suppression(g_settings_get_int(settings, "near-end-suppression")) {
+  automatic_delay = g_settings_get_boolean(settings, "automatic-delay") != 0;
+
+  mono_microphone = g_settings_get_boolean(settings, "mono-microphone") != 0;
+
+  stereo_probe = g_settings_get_boolean(settings, "stereo-probe") != 0;
+
+  gconnections.push_back(g_signal_connect(settings, "changed::mono-microphone",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<EchoCanceller*>(user_data);
+
+                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+                                            self->mono_microphone = g_settings_get_boolean(settings, key) != 0;
+
+                                            self->init_speex();
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::stereo-probe",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<EchoCanceller*>(user_data);
+
+                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+                                            self->stereo_probe = g_settings_get_boolean(settings, key) != 0;
+
+                                            self->init_speex();
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::automatic-delay",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<EchoCanceller*>(user_data);
+
+                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+                                            self->automatic_delay = g_settings_get_boolean(settings, key) != 0;
+
+                                            if (!self->automatic_delay && self->probe_delay != 0U) {
+                                              self->probe_delay = 0U;
+
+                                              if (self->echo_state != nullptr) {
+                                                speex_echo_state_reset(self->echo_state);
+                                              }
+                                            }
+                                          }),
+                                          this));
+
   gconnections.push_back(g_signal_connect(settings, "changed::filter-length",
                                           G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
                                             auto* self = static_cast<EchoCanceller*>(user_data);
@@ -91,14 +139,6 @@ EchoCanceller::~EchoCanceller() {
 
   ready = false;
 
-  if (echo_state_L != nullptr) {
-    speex_echo_state_destroy(echo_state_L);
-  }
-
-  if (echo_state_R != nullptr) {
-    speex_echo_state_destroy(echo_state_R);
-  }
-
   free_speex();
 
   data_mutex.unlock();
@@ -115,6 +155,10 @@ void EchoCanceller::setup() {
 
   latency_n_frames = 0U;
 
+  probe_delay = 0U;
+
+  delay_estimator.reset(rate, static_cast<uint>(max_probe_delay * static_cast<float>(rate)));
+
   init_speex();
 }
 
@@ -137,33 +181,23 @@ void EchoCanceller::process(std::span<float>& left_in,
     apply_gain(left_in, right_in, input_gain);
   }
 
-  for (size_t j = 0U; j < left_in.size(); j++) {
-    data_L[j] = static_cast<spx_int16_t>(left_in[j] * (SHRT_MAX + 1));
-    data_R[j] = static_cast<spx_int16_t>(right_in[j] * (SHRT_MAX + 1));
+  simd::mix(left_in, right_in, 0.5F, mic_mix);
 
-    /*
-      This is a very naive and not corect attempt to mitigate the shortcomes discussed at
-      https://github.com/wwmm/easyeffects/issues/1566.
-    */
+  simd::mix(probe_left, probe_right, 0.5F, probe_mix);
 
-    probe_mono[j] = static_cast<spx_int16_t>(0.5F * (probe_left[j] + probe_right[j]) * (SHRT_MAX + 1));
+  if (stereo_probe) {
+    simd::interleave(probe_left, probe_right, probe_interleaved);
+  } else {
+    std::ranges::copy(probe_mix, probe_interleaved.begin());
   }
 
-  speex_echo_cancellation(echo_state_L, data_L.data(), probe_mono.data(), filtered_L.data());
-  speex_echo_cancellation(echo_state_R, data_R.data(), probe_mono.data(), filtered_R.data());
-
-  speex_preprocess_run(state_left, filtered_L.data());
-  speex_preprocess_run(state_right, filtered_R.data());
+  if (automatic_delay) {
+    delay_estimator.push(mic_mix, probe_mix);
 
-  for (size_t j = 0U; j < filtered_L.size(); j++) {
-    left_out[j] = static_cast<float>(filtered_L[j]) * inv_short_max;
-
-    right_out[j] = static_cast<float>(filtered_R[j]) * inv_short_max;
+    update_probe_delay();
   }
 
-  if (output_gain != 1.0F) {
-    apply_gain(left_out, right_out, output_gain);
-  }
+  delay_probe();
 
   if (notify_latency) {
     const float latency_value = static_cast<float>(latency_n_frames) / static_cast<float>(rate);
@@ -183,81 +217,189 @@ void EchoCanceller::process(std::span<float>& left_in,
     notify_latency = false;
   }
 
+  // The probe history and the delay estimate have to follow the pauses too. Only the speex calls are skipped.
+
+  if (skip_without_voice(left_in, right_in, left_out, right_out)) {
+    return;
+  }
+
+  /*
+    A single multichannel echo state is shared by all microphone channels. So the far end transform is calculated only
+    once per block. In the mono microphone mode the channels are summed and processed as one.
+  */
+
+  if (mono_microphone) {
+    simd::float_to_int16(mic_mix, mic);
+  } else {
+    simd::interleave(left_in, right_in, mic_interleaved);
+
+    simd::float_to_int16(mic_interleaved, mic);
+  }
+
+  simd::float_to_int16(probe_delayed, far_end);
+
+  speex_echo_cancellation(echo_state, mic.data(), far_end.data(), filtered.data());
+
+  if (mono_microphone) {
+    speex_preprocess_run(state_left, filtered.data());
+
+    simd::int16_to_float(filtered, left_out);
+
+    std::ranges::copy(left_out, right_out.begin());
+  } else {
+    for (size_t n = 0U; n < left_in.size(); n++) {
+      filtered_L[n] = filtered[2U * n];
+      filtered_R[n] = filtered[2U * n + 1U];
+    }
+
+    speex_preprocess_run(state_left, filtered_L.data());
+    speex_preprocess_run(state_right, filtered_R.data());
+
+    simd::int16_to_float(filtered_L, left_out);
+    simd::int16_to_float(filtered_R, right_out);
+  }
+
+  if (output_gain != 1.0F) {
+    apply_gain(left_out, right_out, output_gain);
+  }
+
+  fade_without_voice(left_out, right_out);
+
   if (post_messages) {
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
+      const auto delay = (automatic_delay) ? delay_estimator.get_delay() : -1;
+
+      estimated_delay.emit((delay < 0) ? -1.0F : 1000.0F * static_cast<float>(delay) / static_cast<float>(rate));
+
       notify();
     }
   }
 }
 
+void EchoCanceller::update_probe_delay() {
+  const auto estimate = delay_estimator.get_delay();
+
+  if (estimate < 0) {
+    return;
+  }
+
+  /*
+    The probe is delayed a little less than the estimate. This way the echo path the adaptive filter has to model
+    still starts after its first tap and the filter can be short.
+  */
+
+  const auto margin = static_cast<int>(rate / 100U);  // 10 ms
+
+  const auto target = std::max(estimate - margin, 0);
+
+  // small changes are absorbed by the adaptive filter. Resetting it for them would only slow down the convergence
+
+  if (std::abs(target - static_cast<int>(probe_delay)) <= margin / 2) {
+    return;
+  }
+
+  probe_delay = static_cast<uint>(target);
+
+  speex_echo_state_reset(echo_state);
+
+  util::debug(log_tag + name + " probe delay: " + util::to_string(probe_delay) + " samples");
+}
+
+void EchoCanceller::delay_probe() {
+  // The probe channels are interleaved. So the delay in samples is the delay in frames times the number of channels.
+
+  const auto size = static_cast<uint>(probe_history.size());
+
+  const auto delay = probe_delay * n_speakers;
+
+  for (size_t n = 0U; n < probe_interleaved.size(); n++) {
+    probe_history[probe_history_position] = probe_interleaved[n];
+
+    probe_delayed[n] = probe_history[(probe_history_position + size - delay) % size];
+
+    probe_history_position = (probe_history_position + 1U) % size;
+  }
+}
+
 void EchoCanceller::init_speex() {
   if (n_samples == 0U || rate == 0U) {
     return;
   }
 
-  data_L.resize(n_samples);
-  data_R.resize(n_samples);
-  probe_mono.resize(n_samples);
+  ready = false;
+
+  n_microphones = (mono_microphone) ? 1U : 2U;
+  n_speakers = (stereo_probe) ? 2U : 1U;
+
+  mic_mix.resize(n_samples);
+  mic_interleaved.resize(2U * n_samples);
+  mic.resize(n_microphones * n_samples);
+  filtered.resize(n_microphones * n_samples);
   filtered_L.resize(n_samples);
   filtered_R.resize(n_samples);
 
+  probe_mix.resize(n_samples);
+  probe_interleaved.resize(n_speakers * n_samples);
+  probe_delayed.resize(n_speakers * n_samples);
+  far_end.resize(n_speakers * n_samples);
+
+  probe_history.assign(n_speakers * (static_cast<size_t>(max_probe_delay * static_cast<float>(rate)) + n_samples),
+                       0.0F);
+
+  probe_history_position = 0U;
+
   const uint filter_length = static_cast<uint>(0.001F * static_cast<float>(filter_length_ms * rate));
 
   util::debug(log_tag + name + " filter length: " + util::to_string(filter_length));
 
-  if (echo_state_L != nullptr) {
-    speex_echo_state_destroy(echo_state_L);
-  }
+  free_speex();
 
-  echo_state_L = speex_echo_state_init(static_cast<int>(n_samples), static_cast<int>(filter_length));
+  echo_state = speex_echo_state_init_mc(static_cast<int>(n_samples), static_cast<int>(filter_length),
+                                        static_cast<int>(n_microphones), static_cast<int>(n_speakers));
 
-  if (speex_echo_ctl(echo_state_L, SPEEX_ECHO_SET_SAMPLING_RATE, &rate) != 0) {
-    util::warning(log_tag + name + "SPEEX_ECHO_SET_SAMPLING_RATE: unknown request");
-  }
+  if (echo_state == nullptr) {
+    util::warning(log_tag + name + " failed to create the echo canceller state");
 
-  if (echo_state_R != nullptr) {
-    speex_echo_state_destroy(echo_state_R);
+    return;
   }
 
-  echo_state_R = speex_echo_state_init(static_cast<int>(n_samples), static_cast<int>(filter_length));
-
-  if (speex_echo_ctl(echo_state_R, SPEEX_ECHO_SET_SAMPLING_RATE, &rate) != 0) {
+  if (speex_echo_ctl(echo_state, SPEEX_ECHO_SET_SAMPLING_RATE, &rate) != 0) {
     util::warning(log_tag + name + "SPEEX_ECHO_SET_SAMPLING_RATE: unknown request");
   }
 
-  if (state_left != nullptr) {
-    speex_preprocess_state_destroy(state_left);
-  }
-
-  if (state_right != nullptr) {
-    speex_preprocess_state_destroy(state_right);
-  }
+  /*
+    The preprocessor works on a single channel. Each microphone channel has its own one and all of them take the
+    residual echo estimate from the shared echo state.
+  */
 
   state_left = speex_preprocess_state_init(static_cast<int>(n_samples), static_cast<int>(rate));
-  state_right = speex_preprocess_state_init(static_cast<int>(n_samples), static_cast<int>(rate));
-
-  if (state_left != nullptr) {
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_ECHO_STATE, echo_state_L);
-
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS, &residual_echo_suppression);
 
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS_ACTIVE, &near_end_suppression);
+  if (!mono_microphone) {
+    state_right = speex_preprocess_state_init(static_cast<int>(n_samples), static_cast<int>(rate));
   }
 
-  if (state_right != nullptr) {
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_ECHO_STATE, echo_state_R);
+  for (auto* state : {state_left, state_right}) {
+    if (state == nullptr) {
+      continue;
+    }
 
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS, &residual_echo_suppression);
+    speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_ECHO_STATE, echo_state);
 
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS_ACTIVE, &near_end_suppression);
+    speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS, &residual_echo_suppression);
+
+    speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_ECHO_SUPPRESS_ACTIVE, &near_end_suppression);
   }
 
-  ready = true;
+  ready = state_left != nullptr && (mono_microphone || state_right != nullptr);
 }
 
 void EchoCanceller::free_speex() {
+  if (echo_state != nullptr) {
+    speex_echo_state_destroy(echo_state);
+  }
+
   if (state_left != nullptr) {
     speex_preprocess_state_destroy(state_left);
   }
@@ -266,6 +408,7 @@ void EchoCanceller::free_speex() {
     speex_preprocess_state_destroy(state_right);
   }
 
+  echo_state = nullptr;
   state_left = nullptr;
   state_right = nullptr;
 }
@@ -37,6 +37,12 @@ void EchoCancellerPreset::save(nlohmann::json& json) {
 
   json[section][instance_name]["filter-length"] = g_settings_get_int(settings, "filter-length");
 
+  json[section][instance_name]["automatic-delay"] = g_settings_get_boolean(settings, "automatic-delay") != 0;
+
+  json[section][instance_name]["mono-microphone"] = g_settings_get_boolean(settings, "mono-microphone") != 0;
+
+  json[section][instance_name]["stereo-probe"] = g_settings_get_boolean(settings, "stereo-probe") != 0;
+
   json[section][instance_name]["residual-echo-suppression"] = g_settings_get_int(settings, "residual-echo-suppression");
 
   json[section][instance_name]["near-end-suppression"] = g_settings_get_int(settings, "near-end-suppression");
@@ -51,6 +57,12 @@ void EchoCancellerPreset::load(const nlohmann::json& json) {
 
   update_key<int>(json.at(section).at(instance_name), settings, "filter-length", "filter-length");
 
+  update_key<bool>(json.at(section).at(instance_name), settings, "automatic-delay", "automatic-delay");
+
+  update_key<bool>(json.at(section).at(instance_name), settings, "mono-microphone", "mono-microphone");
+
+  update_key<bool>(json.at(section).at(instance_name), settings, "stereo-probe", "stereo-probe");
+
   update_key<int>(json.at(section).at(instance_name), settings, "residual-echo-suppression",
                   "residual-echo-suppression");
 
@@ -46,6 +46,10 @@ struct _EchoCancellerBox {
 
   GtkSpinButton *filter_length, *residual_echo_suppression, *near_end_suppression;
 
+  GtkSwitch *automatic_delay, *mono_microphone, *stereo_probe;
+
+  GtkLabel* estimated_delay;
+
   GSettings* settings;
 
   Data* data;
@@ -95,13 +99,31 @@ void setup(EchoCancellerBox* self, std::shared_ptr<EchoCanceller> echo_canceller
     });
   }));
 
+  self->data->connections.push_back(echo_canceller->estimated_delay.connect([=](const float value) {
+    util::idle_add([=]() {
+      if (get_ignore_filter_idle_add(serial)) {
+        return;
+      }
+
+      if (!GTK_IS_LABEL(self->estimated_delay)) {
+        return;
+      }
+
+      if (value < 0.0F) {
+        gtk_label_set_text(self->estimated_delay, _("Unknown"));
+      } else {
+        gtk_label_set_text(self->estimated_delay, fmt::format(ui::get_user_locale(), "{0:.1Lf} ms", value).c_str());
+      }
+    });
+  }));
+
   gtk_label_set_text(self->plugin_credit,
                      ui::get_plugin_credit_translated(self->data->echo_canceller->package).c_str());
 
-  gsettings_bind_widgets<"input-gain", "output-gain", "filter-length", "residual-echo-suppression",
-                         "near-end-suppression">(self->settings, self->input_gain, self->output_gain,
-                                                 self->filter_length, self->residual_echo_suppression,
-                                                 self->near_end_suppression);
+  gsettings_bind_widgets<"input-gain", "output-gain", "filter-length", "automatic-delay", "mono-microphone",
+                         "stereo-probe", "residual-echo-suppression", "near-end-suppression">(
+      self->settings, self->input_gain, self->output_gain, self->filter_length, self->automatic_delay,
+      self->mono_microphone, self->stereo_probe, self->residual_echo_suppression, self->near_end_suppression);
 }
 
 void dispose(GObject* object) {
@@ -163,6 +185,10 @@ void echo_canceller_box_class_init(EchoCancellerBoxClass* klass) {
   gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, filter_length);
   gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, residual_echo_suppression);
   gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, near_end_suppression);
+  gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, automatic_delay);
+  gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, mono_microphone);
+  gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, stereo_probe);
+  gtk_widget_class_bind_template_child(widget_class, EchoCancellerBox, estimated_delay);
 
   gtk_widget_class_bind_template_callback(widget_class, on_reset);
 }
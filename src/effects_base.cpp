@@ -81,6 +81,16 @@ EffectsBase::EffectsBase(std::string tag, const std::string& schema, PipeManager
                                                  }),
                                                  this));
 
+  gconnections_global.push_back(g_signal_connect(global_settings, "changed::offload-heavy-plugins",
+                                                 G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                                   auto* self = static_cast<EffectsBase*>(user_data);
+
+                                                   self->update_async_plugins();
+
+                                                   self->broadcast_pipeline_latency();
+                                                 }),
+                                                 this));
+
   auto notification_time_window =
       0.001F * static_cast<float>(g_settings_get_int(global_settings, "meters-update-interval"));
 
@@ -178,6 +188,8 @@ void EffectsBase::create_filters_if_necessary() {
       filter = std::make_shared<Limiter>(log_tag, tags::schema::limiter::id, path, pm);
     } else if (name.starts_with(tags::plugin_name::loudness)) {
       filter = std::make_shared<Loudness>(log_tag, tags::schema::loudness::id, path, pm);
+    } else if (name.starts_with(tags::plugin_name::lv2_plugin)) {
+      filter = std::make_shared<Lv2Plugin>(log_tag, tags::schema::lv2_plugin::id, path, pm);
     } else if (name.starts_with(tags::plugin_name::maximizer)) {
       filter = std::make_shared<Maximizer>(log_tag, tags::schema::maximizer::id, path, pm);
     } else if (name.starts_with(tags::plugin_name::multiband_compressor)) {
@@ -200,34 +212,125 @@ void EffectsBase::create_filters_if_necessary() {
 
     plugins.insert(std::make_pair(name, filter));
   }
+
+  share_loudness_analysis();
+
+  share_voice_activity();
+
+  update_async_plugins();
 }
 
 void EffectsBase::remove_unused_filters() {
   const auto list = util::gchar_array_to_vector(g_settings_get_strv(settings, "plugins"));
 
-  if (list.empty()) {
-    plugins.clear();
+  // the plugins put back in the chain are used again as they are
 
-    return;
+  std::erase_if(unused_plugins, [&](const auto& name) { return std::ranges::find(list, name) != list.end(); });
+
+  for (const auto& name : plugins | std::views::keys) {
+    const auto in_chain = std::ranges::find(list, name) != list.end();
+    const auto kept = std::ranges::find(unused_plugins, name) != unused_plugins.end();
+
+    if (!in_chain && !kept) {
+      util::debug(log_tag + name + " is not in the chain anymore. Keeping it for a while.");
+
+      unused_plugins.push_back(name);
+    }
+  }
+
+  while (unused_plugins.size() > max_unused_plugins) {
+    const auto name = unused_plugins.front();
+
+    unused_plugins.pop_front();
+
+    auto plugin = plugins[name];
+
+    plugin->set_bypass(true);
+    plugin->set_post_messages(false);
+    plugin->latency.clear();
+
+    if (plugin->connected_to_pw) {
+      plugin->disconnect_from_pw();
+    }
+
+    plugins.erase(name);
+
+    /*
+      Callbacks the plugin queued with util::idle_add() capture its raw pointer. The last reference is released in an
+      idle of the same priority queued after them. So they never run on a destroyed plugin.
+    */
+
+    util::idle_add([plugin = std::move(plugin), message = log_tag + name]() mutable {
+      plugin.reset();
+
+      util::debug(message + " destroyed because too many unused plugins were kept");
+    });
   }
 
-  for (auto it = plugins.begin(); it != plugins.end();) {
-    auto key = it->first;
+  share_loudness_analysis();
 
-    if (std::ranges::find(list, key) == list.end()) {
-      auto plugin = it->second;
+  share_voice_activity();
+}
 
-      plugin->bypass = true;
-      plugin->set_post_messages(false);
-      plugin->latency.clear();
+void EffectsBase::share_loudness_analysis() {
+  // Whether the level meter and the autogain really see the same signal is checked in the realtime thread
 
-      if (plugin->connected_to_pw) {
-        plugin->disconnect_from_pw();
+  std::vector<std::shared_ptr<LoudnessAnalyzer>> analyzers;
+
+  for (const auto& [name, plugin] : plugins) {
+    if (name.starts_with(tags::plugin_name::level_meter)) {
+      analyzers.push_back(std::dynamic_pointer_cast<LevelMeter>(plugin)->analyzer);
+    }
+  }
+
+  for (const auto& [name, plugin] : plugins) {
+    if (name.starts_with(tags::plugin_name::autogain)) {
+      std::dynamic_pointer_cast<AutoGain>(plugin)->set_loudness_sources(analyzers);
+    }
+  }
+}
+
+void EffectsBase::share_voice_activity() {
+  // Only the plugins placed after the first noise reduction can follow its voice activity detector
+
+  std::shared_ptr<RNNoise> detector;
+
+  for (const auto& name : util::gchar_array_to_vector(g_settings_get_strv(settings, "plugins"))) {
+    if (!plugins.contains(name)) {
+      continue;
+    }
+
+    const auto& plugin = plugins[name];
+
+    if (name.starts_with(tags::plugin_name::rnnoise)) {
+      auto rnnoise = std::dynamic_pointer_cast<RNNoise>(plugin);
+
+      rnnoise->set_voice_activity_output((detector == nullptr) ? &voice_active : nullptr);
+
+      if (detector == nullptr) {
+        detector = rnnoise;
+
+        continue;
       }
+    }
+
+    plugin->set_voice_activity((detector != nullptr) ? &voice_active : nullptr);
+  }
+
+  if (detector == nullptr) {
+    voice_active = true;
+  }
+}
+
+void EffectsBase::update_async_plugins() {
+  // Only the plugins whose cost per block is high or bursty are worth one quantum of extra latency
+
+  const auto state = g_settings_get_boolean(global_settings, "offload-heavy-plugins") != 0;
 
-      it = plugins.erase(it);
-    } else {
-      it++;
+  for (const auto& [name, plugin] : plugins) {
+    if (name.starts_with(tags::plugin_name::convolver) || name.starts_with(tags::plugin_name::echo_canceller) ||
+        name.starts_with(tags::plugin_name::pitch) || name.starts_with(tags::plugin_name::rnnoise)) {
+      plugin->set_async(state);
     }
   }
 }
@@ -249,7 +352,7 @@ auto EffectsBase::get_pipeline_latency() -> float {
 
   for (const auto& name : util::gchar_array_to_vector(g_settings_get_strv(settings, "plugins"))) {
     if (plugins.contains(name)) {
-      total += plugins[name]->get_latency_seconds();
+      total += plugins[name]->get_latency_seconds() + plugins[name]->get_async_latency_seconds();
     }
   }
 
@@ -41,7 +41,18 @@ struct Data {
 
   float global_output_level_left, global_output_level_right, pipeline_latency_ms;
 
-  std::vector<double> spectrum_mag, spectrum_x_axis, spectrum_freqs;
+  std::vector<double> spectrum_x_axis;
+
+  std::vector<std::vector<double>> spectrum_mag;
+
+  /*
+    Sparse matrix mapping the fft bins to the chart points. The bins used by the point n are
+    spectrum_bins[spectrum_bins_offset[n]] up to spectrum_bins[spectrum_bins_offset[n + 1] - 1]
+  */
+
+  std::vector<uint> spectrum_bins_offset, spectrum_bins;
+
+  std::vector<double> spectrum_bins_weight;
 
   std::vector<sigc::connection> connections;
 
@@ -82,30 +93,83 @@ struct _EffectsBox {
 G_DEFINE_TYPE(EffectsBox, effects_box, GTK_TYPE_BOX)
 
 void init_spectrum_frequency_axis(EffectsBox* self) {
-  self->data->spectrum_freqs.resize(self->data->spectrum_n_bands);
+  self->data->spectrum_bins_offset.clear();
+  self->data->spectrum_bins.clear();
+  self->data->spectrum_bins_weight.clear();
 
-  for (uint n = 0U; n < self->data->spectrum_n_bands; n++) {
-    self->data->spectrum_freqs[n] = 0.5F * static_cast<float>(self->data->spectrum_rate) * static_cast<float>(n) /
-                                    static_cast<float>(self->data->spectrum_n_bands);
+  if (self->data->spectrum_n_bands < 2U || self->data->spectrum_rate == 0U) {
+    return;
   }
 
-  if (!self->data->spectrum_freqs.empty()) {
-    const auto min_freq = static_cast<float>(g_settings_get_int(self->settings_spectrum, "minimum-frequency"));
-    const auto max_freq = static_cast<float>(g_settings_get_int(self->settings_spectrum, "maximum-frequency"));
+  const auto min_freq = static_cast<float>(g_settings_get_int(self->settings_spectrum, "minimum-frequency"));
+  const auto max_freq = static_cast<float>(g_settings_get_int(self->settings_spectrum, "maximum-frequency"));
 
-    if (min_freq > (max_freq - 100.0F)) {
-      return;
-    }
+  if (min_freq > (max_freq - 100.0F)) {
+    return;
+  }
+
+  auto log_x_axis = util::logspace(min_freq, max_freq, g_settings_get_int(self->settings_spectrum, "n-points"));
+
+  if (log_x_axis.size() < 2U) {
+    return;
+  }
+
+  self->data->spectrum_x_axis.resize(log_x_axis.size());
+
+  for (auto& trace : self->data->spectrum_mag) {
+    trace.resize(log_x_axis.size());
+  }
+
+  std::copy(log_x_axis.begin(), log_x_axis.end(), self->data->spectrum_x_axis.begin());
+
+  /*
+    Each chart point covers the frequencies between the geometric means of its neighbors. At high frequencies many
+    fft bins fall inside this interval and their average is used. At low frequencies the interval may not contain
+    more than one bin and the two bins around the point are linearly interpolated.
+  */
+
+  const auto last_bin = self->data->spectrum_n_bands - 1U;
+
+  const double bin_width = 0.5 * static_cast<double>(self->data->spectrum_rate) / static_cast<double>(last_bin);
+
+  const auto& x = self->data->spectrum_x_axis;
+
+  const auto n_points = x.size();
+
+  for (size_t n = 0U; n < n_points; n++) {
+    self->data->spectrum_bins_offset.push_back(static_cast<uint>(self->data->spectrum_bins.size()));
 
-    auto log_x_axis = util::logspace(min_freq, max_freq, g_settings_get_int(self->settings_spectrum, "n-points"));
+    const double lower = (n > 0U) ? std::sqrt(x[n - 1U] * x[n]) : x[0] * std::sqrt(x[0] / x[1]);
+    const double upper = (n + 1U < n_points) ? std::sqrt(x[n] * x[n + 1U]) : x[n] * std::sqrt(x[n] / x[n - 1U]);
 
-    self->data->spectrum_x_axis.resize(log_x_axis.size());
-    self->data->spectrum_mag.resize(log_x_axis.size());
+    const auto first = static_cast<uint>(std::ceil(lower / bin_width));
+    const auto last = std::min(static_cast<uint>(std::floor(upper / bin_width)), last_bin);
 
-    std::copy(log_x_axis.begin(), log_x_axis.end(), self->data->spectrum_x_axis.begin());
+    if (last > first) {
+      const double weight = 1.0 / static_cast<double>(last - first + 1U);
 
-    ui::chart::set_x_data(self->spectrum_chart, self->data->spectrum_x_axis);
+      for (uint k = first; k <= last; k++) {
+        self->data->spectrum_bins.push_back(k);
+        self->data->spectrum_bins_weight.push_back(weight);
+      }
+    } else {
+      const double position = std::min(x[n] / bin_width, static_cast<double>(last_bin));
+
+      const auto k = std::min(static_cast<uint>(position), last_bin - 1U);
+
+      const double t = position - static_cast<double>(k);
+
+      self->data->spectrum_bins.push_back(k);
+      self->data->spectrum_bins_weight.push_back(1.0 - t);
+
+      self->data->spectrum_bins.push_back(k + 1U);
+      self->data->spectrum_bins_weight.push_back(t);
+    }
   }
+
+  self->data->spectrum_bins_offset.push_back(static_cast<uint>(self->data->spectrum_bins.size()));
+
+  ui::chart::set_x_data(self->spectrum_chart, self->data->spectrum_x_axis);
 }
 
 void setup_spectrum(EffectsBox* self) {
@@ -114,6 +178,12 @@ void setup_spectrum(EffectsBox* self) {
 
   ui::chart::set_color(self->spectrum_chart, util::gsettings_get_color(self->settings_spectrum, "color"));
 
+  // colors of the traces drawn over the first one when more than one channel is analyzed
+
+  ui::chart::set_traces_colors(self->spectrum_chart, {GdkRGBA{0.95F, 0.35F, 0.35F, 1.0F},
+                                                      GdkRGBA{0.35F, 0.75F, 0.95F, 1.0F},
+                                                      GdkRGBA{0.95F, 0.80F, 0.35F, 1.0F}});
+
   ui::chart::set_axis_labels_color(self->spectrum_chart,
                                    util::gsettings_get_color(self->settings_spectrum, "color-axis-labels"));
 
@@ -349,8 +419,8 @@ void setup(EffectsBox* self, app::Application* application, PipelineType pipelin
 
   // spectrum array
 
-  self->data->connections.push_back(
-      self->data->effects_base->spectrum->power.connect([=](uint rate, uint n_bands, std::vector<double> magnitudes) {
+  self->data->connections.push_back(self->data->effects_base->spectrum->power.connect(
+      [=](uint rate, uint n_bands, const std::vector<std::vector<double>>& magnitudes) {
         if (!ui::chart::get_is_visible(self->spectrum_chart)) {
           return;
         }
@@ -359,6 +429,14 @@ void setup(EffectsBox* self, app::Application* application, PipelineType pipelin
           return;
         }
 
+        if (self->data->spectrum_mag.size() != magnitudes.size()) {
+          self->data->spectrum_mag.resize(magnitudes.size());
+
+          for (auto& trace : self->data->spectrum_mag) {
+            trace.resize(self->data->spectrum_x_axis.size());
+          }
+        }
+
         if (self->data->spectrum_rate != rate || self->data->spectrum_n_bands != n_bands) {
           self->data->spectrum_rate = rate;
           self->data->spectrum_n_bands = n_bands;
@@ -366,35 +444,36 @@ void setup(EffectsBox* self, app::Application* application, PipelineType pipelin
           init_spectrum_frequency_axis(self);
         }
 
-        auto* acc = gsl_interp_accel_alloc();
-        auto* spline = gsl_spline_alloc(gsl_interp_steffen, n_bands);
+        if (self->data->spectrum_bins_offset.size() != self->data->spectrum_x_axis.size() + 1U) {
+          return;
+        }
+
+        for (size_t t = 0U; t < magnitudes.size(); t++) {
+          if (magnitudes[t].size() != n_bands) {
+            return;
+          }
 
-        gsl_spline_init(spline, self->data->spectrum_freqs.data(), magnitudes.data(), n_bands);
+          auto& trace = self->data->spectrum_mag[t];
 
-        for (size_t n = 0; n < self->data->spectrum_x_axis.size(); n++) {
-          self->data->spectrum_mag[n] =
-              static_cast<float>(gsl_spline_eval(spline, self->data->spectrum_x_axis[n], acc));
-        }
+          for (size_t n = 0U; n < trace.size(); n++) {
+            double v = 0.0;
 
-        gsl_spline_free(spline);
-        gsl_interp_accel_free(acc);
+            for (uint k = self->data->spectrum_bins_offset[n]; k < self->data->spectrum_bins_offset[n + 1U]; k++) {
+              v += self->data->spectrum_bins_weight[k] * magnitudes[t][self->data->spectrum_bins[k]];
+            }
 
-        std::ranges::for_each(self->data->spectrum_mag, [](auto& v) {
-          v = 10.0F * std::log10(v);
+            v = 10.0 * std::log10(v);
 
-          if (!std::isinf(v)) {
-            v = (v > util::minimum_db_level) ? v : util::minimum_db_level;
-          } else {
-            v = util::minimum_db_level;
+            trace[n] = (!std::isinf(v) && v > util::minimum_db_level) ? v : util::minimum_db_level;
           }
-        });
+        }
 
         ui::chart::set_y_data(self->spectrum_chart, self->data->spectrum_mag);
       }));
 
   // As we are showing the window we want the filters to send notifications about level meters, etc
 
-  self->data->effects_base->spectrum->bypass = g_settings_get_boolean(self->settings_spectrum, "show") == 0;
+  self->data->effects_base->spectrum->set_bypass(g_settings_get_boolean(self->settings_spectrum, "show") == 0);
 
   self->data->effects_base->output_level->set_post_messages(true);
 
@@ -445,7 +524,7 @@ void dispose(GObject* object) {
 
   schedule_signal_idle = false;
 
-  self->data->effects_base->spectrum->bypass = true;
+  self->data->effects_base->spectrum->set_bypass(true);
 
   self->data->effects_base->output_level->set_post_messages(false);
 
@@ -526,12 +605,12 @@ void effects_box_init(EffectsBox* self) {
   gtk_box_insert_child_after(GTK_BOX(self), GTK_WIDGET(self->spectrum_chart), nullptr);
 
   g_signal_connect(GTK_WIDGET(self->spectrum_chart), "show", G_CALLBACK(+[](GtkWidget* widget, EffectsBox* self) {
-                     self->data->effects_base->spectrum->bypass = false;
+                     self->data->effects_base->spectrum->set_bypass(false);
                    }),
                    self);
 
   g_signal_connect(GTK_WIDGET(self->spectrum_chart), "hide", G_CALLBACK(+[](GtkWidget* widget, EffectsBox* self) {
-                     self->data->effects_base->spectrum->bypass = true;
+                     self->data->effects_base->spectrum->set_bypass(true);
                    }),
                    self);
 }
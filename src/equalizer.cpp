@@ -78,6 +78,8 @@ Equalizer::Equalizer(const std::string& tag,
       settings, "changed::split-channels",
       G_CALLBACK(+[](GSettings* settings, char* key, Equalizer* self) { self->on_split_channels(); }), this));
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+
   setup_input_output_gain();
 }
 
@@ -223,7 +225,7 @@ void Equalizer::process(std::span<float>& left_in,
     This plugin gives the latency in number of samples
   */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
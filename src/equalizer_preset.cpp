@@ -136,6 +136,16 @@ void EqualizerPreset::load(const nlohmann::json& json) {
 }
 
 void EqualizerPreset::load_channel(const nlohmann::json& json, GSettings* settings, const int& nbands) {
+  /*
+    Like the main settings in PluginPresetBase::read the changes are delayed and applied together. A channel has 8 keys
+    per band and more than 256 delayed changes crash the application (see issue #2215). So like in
+    util::reset_all_keys_except they are applied every 16 bands, which is at most 128 changes.
+  */
+
+  constexpr int bands_per_apply = 16;
+
+  g_settings_delay(settings);
+
   for (int n = 0; n < nbands; n++) {
     const auto bandn = "band" + util::to_string(n);
 
@@ -154,5 +164,11 @@ void EqualizerPreset::load_channel(const nlohmann::json& json, GSettings* settin
     update_key<double>(json.at(bandn), settings, band_frequency[n].data(), "frequency");
 
     update_key<double>(json.at(bandn), settings, band_q[n].data(), "q");
+
+    if ((n + 1) % bands_per_apply == 0) {
+      g_settings_apply(settings);
+    }
   }
+
+  g_settings_apply(settings);
 }
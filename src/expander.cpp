@@ -91,6 +91,12 @@ Expander::Expander(const std::string& tag,
 
   lv2_wrapper->bind_key_double_db<"cwt", "wet", false>(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+  reduction_port = lv2_wrapper->find_control_port("rlm");
+  sidechain_port = lv2_wrapper->find_control_port("slm");
+  curve_port = lv2_wrapper->find_control_port("clm");
+  envelope_port = lv2_wrapper->find_control_port("elm");
+
   setup_input_output_gain();
 }
 
@@ -142,7 +148,7 @@ void Expander::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -166,10 +172,10 @@ void Expander::process(std::span<float>& left_in,
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
-      reduction_port_value = lv2_wrapper->get_control_port_value("rlm");
-      sidechain_port_value = lv2_wrapper->get_control_port_value("slm");
-      curve_port_value = lv2_wrapper->get_control_port_value("clm");
-      envelope_port_value = lv2_wrapper->get_control_port_value("elm");
+      reduction_port_value = lv2_wrapper->get_control_port_value(reduction_port);
+      sidechain_port_value = lv2_wrapper->get_control_port_value(sidechain_port);
+      curve_port_value = lv2_wrapper->get_control_port_value(curve_port);
+      envelope_port_value = lv2_wrapper->get_control_port_value(envelope_port);
 
       reduction.emit(reduction_port_value);
       sidechain.emit(sidechain_port_value);
@@ -19,12 +19,20 @@
 
 #include "fir_filter_base.hpp"
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 namespace {
 
 constexpr auto CONVPROC_SCHEDULER_PRIORITY = 0;
 
 constexpr auto CONVPROC_SCHEDULER_CLASS = SCHED_FIFO;
 
+std::mutex kernel_cache_mutex;
+
+std::map<std::tuple<int, uint, float, float, float>, std::vector<float>> kernel_cache;
+
 }  // namespace
 
 FirFilterBase::FirFilterBase(std::string tag) : log_tag(std::move(tag)) {}
@@ -94,44 +102,128 @@ auto FirFilterBase::create_lowpass_kernel(const float& cutoff, const float& tran
     cutoff frequency as a fraction of the sample rate
   */
 
-  const float fc = cutoff / static_cast<float>(rate);
+  const double fc = static_cast<double>(cutoff) / static_cast<double>(rate);
 
-  float sum = 0.0F;
+  const uint center = M / 2U;
 
-  for (size_t n = 0U; n < output.size(); n++) {
+  /*
+    The kernel is symmetric around its center. So only half of it has to be calculated. The sums are done in double
+    precision because thousands of taps are added together for the narrow transition bands.
+  */
+
+  const double h_center = 2.0 * std::numbers::pi * fc;
+
+  output[center] = static_cast<float>(h_center);
+
+  double sum = h_center;
+
+  for (uint n = 0U; n < center; n++) {
     /*
       windowed-sinc kernel https://www.dspguide.com/ch16/1.htm
     */
 
-    if (n == M / 2U) {
-      output[n] = 2.0F * std::numbers::pi_v<float> * fc;
-    } else {
-      output[n] = std::sin(2.0F * std::numbers::pi_v<float> * fc * static_cast<float>(n - static_cast<uint>(M / 2U))) /
-                  static_cast<float>(n - static_cast<uint>(M / 2U));
-    }
+    const auto k = static_cast<double>(n) - static_cast<double>(center);
+
+    const double h = std::sin(2.0 * std::numbers::pi * fc * k) / k;
 
     /*
       Blackman window https://www.dspguide.com/ch16/1.htm
     */
 
-    const float w = 0.42F -
-                    0.5F * std::cos(2.0F * std::numbers::pi_v<float> * static_cast<float>(n) / static_cast<float>(M)) +
-                    0.08F * std::cos(4.0F * std::numbers::pi_v<float> * static_cast<float>(n) / static_cast<float>(M));
+    const double w = 0.42 - 0.5 * std::cos(2.0 * std::numbers::pi * static_cast<double>(n) / static_cast<double>(M)) +
+                     0.08 * std::cos(4.0 * std::numbers::pi * static_cast<double>(n) / static_cast<double>(M));
 
-    output[n] *= w;
+    output[n] = static_cast<float>(h * w);
+    output[M - n] = output[n];
 
-    sum += output[n];
+    sum += 2.0 * h * w;
   }
 
   /*
     Normalizing so that we have unit gain at zero frequency
   */
 
-  std::ranges::for_each(output, [&](auto& v) { v /= sum; });
+  std::ranges::for_each(output, [&](auto& v) { v = static_cast<float>(v / sum); });
+
+  return output;
+}
+
+auto FirFilterBase::create_highpass_kernel(const float& cutoff, const float& transition_band) const
+    -> std::vector<float> {
+  auto output = create_lowpass_kernel(cutoff, transition_band);
+
+  if (output.empty()) {
+    return output;
+  }
+
+  /*
+    Creating a highpass from a lowpass through spectral inversion https://www.dspguide.com/ch16/4.htm
+  */
+
+  std::ranges::for_each(output, [](auto& v) { v *= -1.0F; });
+
+  output[(output.size() - 1U) / 2U] += 1.0F;
 
   return output;
 }
 
+auto FirFilterBase::create_bandpass_kernel(const float& low_cutoff,
+                                           const float& high_cutoff,
+                                           const float& transition_band) const -> std::vector<float> {
+  /*
+    The bandpass is the difference between two lowpass kernels with the same size. Each one has unit gain at zero
+    frequency. So the result has unit gain in the pass band and no gain at zero frequency. As everything is linear
+    this is the same kernel we would get convolving a lowpass with a highpass but it costs O(M) instead of O(M^2).
+  */
+
+  auto output = create_lowpass_kernel(high_cutoff, transition_band);
+
+  const auto lowpass = create_lowpass_kernel(low_cutoff, transition_band);
+
+  for (size_t n = 0U; n < output.size(); n++) {
+    output[n] -= lowpass[n];
+  }
+
+  return output;
+}
+
+void FirFilterBase::load_kernel(const KernelType& type) {
+  /*
+    The kernels only depend on the sample rate and on the frequencies. So they are shared by all filters in the
+    process and a new one is designed only the first time a combination of parameters is seen. This way a change of
+    quantum or the destruction and creation of a plugin does not design the same kernels again.
+  */
+
+  const float low = (type == KernelType::lowpass) ? 0.0F : min_frequency;
+  const float high = (type == KernelType::highpass) ? 0.0F : max_frequency;
+
+  const auto key = std::make_tuple(static_cast<int>(type), rate, low, high, transition_band);
+
+  std::scoped_lock<std::mutex> lock(kernel_cache_mutex);
+
+  if (const auto it = kernel_cache.find(key); it != kernel_cache.end()) {
+    kernel = it->second;
+
+    return;
+  }
+
+  switch (type) {
+    case KernelType::lowpass:
+      kernel = create_lowpass_kernel(high, transition_band);
+      break;
+    case KernelType::highpass:
+      kernel = create_highpass_kernel(low, transition_band);
+      break;
+    case KernelType::bandpass:
+      kernel = create_bandpass_kernel(low, high, transition_band);
+      break;
+  }
+
+  if (!kernel.empty()) {
+    kernel_cache[key] = kernel;
+  }
+}
+
 void FirFilterBase::setup_zita() {
   zita_ready = false;
 
@@ -191,20 +283,6 @@ void FirFilterBase::setup_zita() {
   zita_ready = true;
 }
 
-void FirFilterBase::direct_conv(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& c) {
-  const uint M = (c.size() + 1U) / 2U;
-
-  for (uint n = 0U; n < c.size(); n++) {
-    c[n] = 0.0F;
-
-    for (uint m = 0U; m < M; m++) {
-      if (n > m && n - m < M) {
-        c[n] += a[n - m] * b[m];
-      }
-    }
-  }
-}
-
 auto FirFilterBase::get_delay() const -> float {
   return delay;
 }
@@ -24,11 +24,7 @@ FirFilterHighpass::FirFilterHighpass(std::string tag) : FirFilterBase(std::move(
 FirFilterHighpass::~FirFilterHighpass() = default;
 
 void FirFilterHighpass::setup() {
-  kernel = create_lowpass_kernel(min_frequency, transition_band);
-
-  std::ranges::for_each(kernel, [](auto& v) { v *= -1.0F; });
-
-  kernel[(kernel.size() - 1U) / 2U] += 1.0F;
+  load_kernel(KernelType::highpass);
 
   delay = 0.5F * static_cast<float>(kernel.size() - 1U) / static_cast<float>(rate);
 
@@ -24,7 +24,7 @@ FirFilterLowpass::FirFilterLowpass(std::string tag) : FirFilterBase(std::move(ta
 FirFilterLowpass::~FirFilterLowpass() = default;
 
 void FirFilterLowpass::setup() {
-  kernel = create_lowpass_kernel(max_frequency, transition_band);
+  load_kernel(KernelType::lowpass);
 
   delay = 0.5F * static_cast<float>(kernel.size() - 1U) / static_cast<float>(rate);
 
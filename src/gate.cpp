@@ -90,6 +90,17 @@ Gate::Gate(const std::string& tag, const std::string& schema, const std::string&
 
   lv2_wrapper->bind_key_double_db<"cwt", "wet", false>(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+  attack_zone_start_port = lv2_wrapper->find_control_port("gzs");
+  attack_threshold_port = lv2_wrapper->find_control_port("gt");
+  release_zone_start_port = lv2_wrapper->find_control_port("hts");
+  release_threshold_port = lv2_wrapper->find_control_port("hzs");
+  reduction_port = lv2_wrapper->find_control_port("rlm");
+  sidechain_port = lv2_wrapper->find_control_port("slm");
+  curve_port = lv2_wrapper->find_control_port("clm");
+  envelope_port = lv2_wrapper->find_control_port("elm");
+  max_reduction_port = lv2_wrapper->find_control_port("gr");
+
   setup_input_output_gain();
 }
 
@@ -141,7 +152,7 @@ void Gate::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -165,19 +176,20 @@ void Gate::process(std::span<float>& left_in,
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
-      attack_zone_start_port_value = lv2_wrapper->get_control_port_value("gzs");
-      attack_threshold_port_value = lv2_wrapper->get_control_port_value("gt");
-      release_zone_start_port_value = lv2_wrapper->get_control_port_value("hts");
-      release_threshold_port_value = lv2_wrapper->get_control_port_value("hzs");
-      reduction_port_value = lv2_wrapper->get_control_port_value("rlm");
-      sidechain_port_value = lv2_wrapper->get_control_port_value("slm");
-      curve_port_value = lv2_wrapper->get_control_port_value("clm");
-      envelope_port_value = lv2_wrapper->get_control_port_value("elm");
+      attack_zone_start_port_value = lv2_wrapper->get_control_port_value(attack_zone_start_port);
+      attack_threshold_port_value = lv2_wrapper->get_control_port_value(attack_threshold_port);
+      release_zone_start_port_value = lv2_wrapper->get_control_port_value(release_zone_start_port);
+      release_threshold_port_value = lv2_wrapper->get_control_port_value(release_threshold_port);
+      reduction_port_value = lv2_wrapper->get_control_port_value(reduction_port);
+      sidechain_port_value = lv2_wrapper->get_control_port_value(sidechain_port);
+      curve_port_value = lv2_wrapper->get_control_port_value(curve_port);
+      envelope_port_value = lv2_wrapper->get_control_port_value(envelope_port);
 
       // Normalize the current gain reduction amount as a percentage,
       // where 0% is no gating, and 100% is a fully closed gate.
       // Double needed for the level bar widget.
-      const double max_reduction_port_value = static_cast<double>(lv2_wrapper->get_control_port_value("gr"));
+      const double max_reduction_port_value =
+          static_cast<double>(lv2_wrapper->get_control_port_value(max_reduction_port));
       // no reduction defaults to 1.0; aka db_to_linear(0 dB);
       gating_port_value = util::normalize(reduction_port_value, max_reduction_port_value);
 
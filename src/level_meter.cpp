@@ -25,7 +25,7 @@ LevelMeter::LevelMeter(const std::string& tag,
                        PipeManager* pipe_manager)
     : PluginBase(tag,
                  tags::plugin_name::level_meter,
-                 tags::plugin_package::ebur128,
+                 tags::plugin_package::ee,
                  schema,
                  schema_path,
                  pipe_manager) {}
@@ -41,49 +41,29 @@ LevelMeter::~LevelMeter() {
 
   mythreads.clear();
 
-  std::scoped_lock<std::mutex> lock(data_mutex);
-
-  if (ebur_state != nullptr) {
-    ebur128_destroy(&ebur_state);
-  }
-
   util::debug(log_tag + name + " destroyed");
 }
 
-auto LevelMeter::init_ebur128() -> bool {
+auto LevelMeter::init_analyzer() -> bool {
   if (n_samples == 0 || rate == 0) {
     return false;
   }
 
-  if (ebur_state != nullptr) {
-    ebur128_destroy(&ebur_state);
-
-    ebur_state = nullptr;
-  }
-
-  ebur_state = ebur128_init(
-      2U, rate, EBUR128_MODE_S | EBUR128_MODE_I | EBUR128_MODE_LRA | EBUR128_MODE_TRUE_PEAK | EBUR128_MODE_HISTOGRAM);
-
-  ebur128_set_channel(ebur_state, 0U, EBUR128_LEFT);
-  ebur128_set_channel(ebur_state, 1U, EBUR128_RIGHT);
+  analyzer->init(rate, true);
 
-  return ebur_state != nullptr;
+  return analyzer->is_ready();
 }
 
 void LevelMeter::setup() {
-  if (2U * static_cast<size_t>(n_samples) != data.size()) {
-    data.resize(static_cast<size_t>(n_samples) * 2U);
-  }
-
   if (rate != old_rate) {
     data_mutex.lock();
 
-    ebur128_ready = false;
+    analyzer_ready = false;
 
     data_mutex.unlock();
 
     mythreads.emplace_back([this]() {  // Using emplace_back here makes sense
-      if (ebur128_ready) {
+      if (analyzer_ready) {
         return;
       }
 
@@ -91,11 +71,11 @@ void LevelMeter::setup() {
 
       old_rate = rate;
 
-      status = init_ebur128();
+      status = init_analyzer();
 
       data_mutex.lock();
 
-      ebur128_ready = status;
+      analyzer_ready = status;
 
       data_mutex.unlock();
     });
@@ -111,44 +91,20 @@ void LevelMeter::process(std::span<float>& left_in,
   std::copy(left_in.begin(), left_in.end(), left_out.begin());
   std::copy(right_in.begin(), right_in.end(), right_out.begin());
 
-  if (bypass || !ebur128_ready) {
+  if (bypass || !analyzer_ready) {
     return;
   }
 
-  for (size_t n = 0U; n < n_samples; n++) {
-    data[2U * n] = left_in[n];
-    data[2U * n + 1U] = right_in[n];
-  }
-
-  ebur128_add_frames_float(ebur_state, data.data(), n_samples);
+  analyzer->process(left_in, right_in, clock_position);
 
-  if (EBUR128_SUCCESS != ebur128_loudness_momentary(ebur_state, &momentary)) {
-    momentary = 0.0;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_loudness_shortterm(ebur_state, &shortterm)) {
-    shortterm = 0.0;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_loudness_global(ebur_state, &global)) {
-    global = 0.0;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_relative_threshold(ebur_state, &relative)) {
-    relative = 0.0;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_loudness_range(ebur_state, &range)) {
-    range = 0.0;
-  }
+  momentary = analyzer->momentary();
+  shortterm = analyzer->shortterm();
+  global = analyzer->integrated();
+  relative = analyzer->relative_threshold();
+  range = analyzer->range();
 
-  if (EBUR128_SUCCESS != ebur128_true_peak(ebur_state, 0U, &true_peak_L)) {
-    true_peak_L = 0.0;
-  }
-
-  if (EBUR128_SUCCESS != ebur128_true_peak(ebur_state, 1U, &true_peak_R)) {
-    true_peak_R = 0.0;
-  }
+  true_peak_L = analyzer->true_peak(0U);
+  true_peak_R = analyzer->true_peak(1U);
 
   if (post_messages) {
     get_peaks(left_in, right_in, left_out, right_out);
@@ -169,15 +125,15 @@ void LevelMeter::reset_history() {
   mythreads.emplace_back([this]() {  // Using emplace_back here makes sense
     data_mutex.lock();
 
-    ebur128_ready = false;
+    analyzer_ready = false;
 
     data_mutex.unlock();
 
-    auto status = init_ebur128();
+    auto status = init_analyzer();
 
     data_mutex.lock();
 
-    ebur128_ready = status;
+    analyzer_ready = status;
 
     data_mutex.unlock();
   });
@@ -78,6 +78,12 @@ Limiter::Limiter(const std::string& tag,
 
   lv2_wrapper->bind_key_bool<"extsc", "external-sidechain">(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+  gain_l_port = lv2_wrapper->find_control_port("grlm_l");
+  gain_r_port = lv2_wrapper->find_control_port("grlm_r");
+  sidechain_l_port = lv2_wrapper->find_control_port("sclm_l");
+  sidechain_r_port = lv2_wrapper->find_control_port("sclm_r");
+
   setup_input_output_gain();
 }
 
@@ -129,7 +135,7 @@ void Limiter::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -153,10 +159,10 @@ void Limiter::process(std::span<float>& left_in,
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
-      gain_l_port_value = lv2_wrapper->get_control_port_value("grlm_l");
-      gain_r_port_value = lv2_wrapper->get_control_port_value("grlm_r");
-      sidechain_l_port_value = lv2_wrapper->get_control_port_value("sclm_l");
-      sidechain_r_port_value = lv2_wrapper->get_control_port_value("sclm_r");
+      gain_l_port_value = lv2_wrapper->get_control_port_value(gain_l_port);
+      gain_r_port_value = lv2_wrapper->get_control_port_value(gain_r_port);
+      sidechain_l_port_value = lv2_wrapper->get_control_port_value(sidechain_l_port);
+      sidechain_r_port_value = lv2_wrapper->get_control_port_value(sidechain_r_port);
 
       gain_left.emit(gain_l_port_value);
       gain_right.emit(gain_r_port_value);
@@ -42,6 +42,8 @@ Loudness::Loudness(const std::string& tag,
 
   lv2_wrapper->bind_key_double<"hcrange", "clipping-range">(settings);
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+
   setup_input_output_gain();
 }
 
@@ -91,7 +93,7 @@ void Loudness::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
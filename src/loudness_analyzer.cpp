@@ -0,0 +1,577 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "loudness_analyzer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numbers>
+
+namespace {
+
+constexpr double absolute_gate = -70.0;  // LUFS
+constexpr double relative_gate = -10.0;  // LU
+constexpr double range_relative_gate = -20.0;
+
+// the gating histograms have bins of 0.1 LU going from the absolute gate up to +30 LUFS
+
+constexpr int n_bins = 1000;
+constexpr double bin_width = 0.1;
+
+// segment energies are summed as fixed point numbers. That way the running sums never drift.
+
+constexpr double fixed_point_scale = 1099511627776.0;  // 2^40
+constexpr double maximum_segment_energy = 1000.0;
+
+constexpr uint maximum_stored_input = 16384U;
+
+auto energy_to_loudness(const double& energy) -> double {
+  return (energy > 0.0) ? -0.691 + 10.0 * std::log10(energy) : -HUGE_VAL;
+}
+
+auto loudness_to_bin(const double& loudness) -> int {
+  return static_cast<int>(std::ceil((loudness - absolute_gate) / bin_width));
+}
+
+auto bin_loudness(const int& bin) -> double {
+  return absolute_gate + (static_cast<double>(bin) + 0.5) * bin_width;
+}
+
+const auto bins_energy = []() {
+  std::array<double, n_bins> energies{};
+
+  for (int n = 0; n < n_bins; n++) {
+    energies[n] = std::pow(10.0, (bin_loudness(n) + 0.691) / 10.0);
+  }
+
+  return energies;
+}();
+
+}  // namespace
+
+void LoudnessAnalyzer::Histogram::init(const uint& history_size) {
+  counts.assign(n_bins, 0U);
+
+  history.assign(history_size, -1);
+
+  n_added = 0U;
+}
+
+void LoudnessAnalyzer::Histogram::set_history_size(const uint& history_size) {
+  if (history_size == history.size()) {
+    return;
+  }
+
+  if (history_size == 0U) {
+    history.clear();
+
+    return;
+  }
+
+  // Without a previous history we do not know which blocks are the newest ones
+
+  std::vector<int> newest_bins;
+
+  if (!history.empty()) {
+    const auto n_kept = std::min({n_added, static_cast<uint64_t>(history.size()), static_cast<uint64_t>(history_size)});
+
+    for (auto n = n_added - n_kept; n < n_added; n++) {
+      newest_bins.push_back(history[n % history.size()]);
+    }
+  }
+
+  init(history_size);
+
+  for (const auto& bin : newest_bins) {
+    history[n_added % history.size()] = bin;
+
+    if (bin >= 0) {
+      counts[bin]++;
+    }
+
+    n_added++;
+  }
+}
+
+void LoudnessAnalyzer::Histogram::add(const double& energy) {
+  const auto loudness = energy_to_loudness(energy);
+
+  const int bin = (loudness < absolute_gate) ? -1 : std::min(static_cast<int>((loudness - absolute_gate) / bin_width),
+                                                             n_bins - 1);
+
+  // When the history is limited the block that leaves it is removed from the histogram
+
+  if (!history.empty()) {
+    auto& slot = history[n_added % history.size()];
+
+    if (n_added >= history.size() && slot >= 0) {
+      counts[slot]--;
+    }
+
+    slot = bin;
+  }
+
+  if (bin >= 0) {
+    counts[bin]++;
+  }
+
+  n_added++;
+}
+
+auto LoudnessAnalyzer::Histogram::gated_energy(const double& threshold_loudness) const
+    -> std::pair<double, uint64_t> {
+  double energy = 0.0;
+
+  uint64_t n_blocks = 0U;
+
+  for (int n = std::clamp(loudness_to_bin(threshold_loudness), 0, n_bins); n < n_bins; n++) {
+    energy += static_cast<double>(counts[n]) * bins_energy[n];
+
+    n_blocks += counts[n];
+  }
+
+  return {(n_blocks != 0U) ? energy / static_cast<double>(n_blocks) : 0.0, n_blocks};
+}
+
+auto LoudnessAnalyzer::Histogram::percentile_loudness(const double& threshold_loudness, const double& fraction) const
+    -> double {
+  const auto first_bin = std::clamp(loudness_to_bin(threshold_loudness), 0, n_bins);
+
+  uint64_t n_blocks = 0U;
+
+  for (int n = first_bin; n < n_bins; n++) {
+    n_blocks += counts[n];
+  }
+
+  if (n_blocks == 0U) {
+    return 0.0;
+  }
+
+  const auto index = static_cast<uint64_t>(static_cast<double>(n_blocks - 1U) * fraction + 0.5);
+
+  uint64_t cumulative = 0U;
+
+  for (int n = first_bin; n < n_bins; n++) {
+    cumulative += counts[n];
+
+    if (cumulative > index) {
+      return bin_loudness(n);
+    }
+  }
+
+  return bin_loudness(n_bins - 1);
+}
+
+void LoudnessAnalyzer::init(const uint& sampling_rate, const bool& measure_true_peak, const uint& max_history_seconds) {
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  ready = false;
+
+  if (sampling_rate == 0U) {
+    return;
+  }
+
+  rate = sampling_rate;
+
+  use_true_peak = measure_true_peak;
+
+  segment_size = std::max((rate + 50U) / 100U, 1U);
+
+  calculate_filters_coefficients();
+
+  frontend = Frontend{};
+
+  frontend.segments.assign(shortterm_segments, 0);
+
+  // The history is given in seconds and we have a gating block every 100 ms
+
+  integrated_histogram.init(10U * max_history_seconds);
+  range_histogram.init(10U * max_history_seconds);
+
+  last_left.reserve(maximum_stored_input);
+  last_right.reserve(maximum_stored_input);
+
+  last_left.clear();
+  last_right.clear();
+
+  last_cycle = 0U;
+  blocks_before_cycle = 0U;
+  blocks_consumed = 0U;
+
+  gating_changed = true;
+
+  ready = true;
+}
+
+void LoudnessAnalyzer::set_maximum_history(const uint& seconds) {
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  integrated_histogram.set_history_size(10U * seconds);
+  range_histogram.set_history_size(10U * seconds);
+
+  gating_changed = true;
+}
+
+void LoudnessAnalyzer::calculate_filters_coefficients() {
+  // High shelf modeling the acoustic effects of the head. The values are the ones given in ITU-R BS.1770.
+
+  double f0 = 1681.974450955533;
+  const double G = 3.999843853973347;
+  double Q = 0.7071752369554196;
+
+  double K = std::tan(std::numbers::pi * f0 / static_cast<double>(rate));
+
+  const double Vh = std::pow(10.0, G / 20.0);
+  const double Vb = std::pow(Vh, 0.4996667741545416);
+
+  double a0 = 1.0 + K / Q + K * K;
+
+  pre_b = {(Vh + Vb * K / Q + K * K) / a0, 2.0 * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0};
+  pre_a = {1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0};
+
+  // RLB high pass
+
+  f0 = 38.13547087602444;
+  Q = 0.5003270373238773;
+
+  K = std::tan(std::numbers::pi * f0 / static_cast<double>(rate));
+
+  a0 = 1.0 + K / Q + K * K;
+
+  rlb_b = {1.0, -2.0, 1.0};
+  rlb_a = {1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0};
+
+  // 4x oversampling interpolator used to estimate the true peak. It is a windowed sinc split in 4 phases.
+
+  constexpr uint n_taps = 4U * n_taps_per_phase;
+
+  std::array<double, n_taps> h{};
+
+  for (uint k = 0U; k < n_taps; k++) {
+    const double m = (static_cast<double>(k) - 0.5 * static_cast<double>(n_taps - 1U)) / 4.0;
+
+    const double sinc = std::sin(std::numbers::pi * m) / (std::numbers::pi * m);
+
+    const double window = 0.5 * (1.0 - std::cos(2.0 * std::numbers::pi * static_cast<double>(k + 1U) /
+                                                static_cast<double>(n_taps + 1U)));
+
+    h[k] = sinc * window;
+  }
+
+  for (uint p = 0U; p < 4U; p++) {
+    double phase_sum = 0.0;
+
+    for (uint t = 0U; t < n_taps_per_phase; t++) {
+      phase_sum += h[4U * t + p];
+    }
+
+    for (uint t = 0U; t < n_taps_per_phase; t++) {
+      true_peak_coefficients[t][p] = static_cast<float>(h[4U * t + p] / phase_sum);
+    }
+  }
+}
+
+void LoudnessAnalyzer::process(std::span<const float> left, std::span<const float> right, const uint64_t& cycle) {
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  if (!ready || left.size() != right.size()) {
+    return;
+  }
+
+  blocks_before_cycle = frontend.n_blocks;
+
+  filter_samples(left, right);
+
+  if (use_true_peak) {
+    update_true_peak(left, right);
+  }
+
+  // Keeping a copy of the input so that other analyzers can check if they are seeing the same signal
+
+  if (left.size() <= maximum_stored_input) {
+    last_left.assign(left.begin(), left.end());
+    last_right.assign(right.begin(), right.end());
+
+    last_cycle = cycle;
+  } else {
+    last_cycle = 0U;
+  }
+
+  consume_blocks();
+}
+
+auto LoudnessAnalyzer::follow(LoudnessAnalyzer& source,
+                              std::span<const float> left,
+                              std::span<const float> right,
+                              const uint64_t& cycle) -> bool {
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  if (!ready || cycle == 0U || &source == this) {
+    return false;
+  }
+
+  // The source belongs to another plugin. We never wait for it.
+
+  std::unique_lock<std::mutex> source_lock(source.mutex, std::try_to_lock);
+
+  if (!source_lock.owns_lock() || !source.ready || source.rate != rate || source.last_cycle != cycle ||
+      (use_true_peak && !source.use_true_peak)) {
+    return false;
+  }
+
+  if (left.size() != source.last_left.size() || right.size() != source.last_right.size() ||
+      std::memcmp(left.data(), source.last_left.data(), left.size_bytes()) != 0 ||
+      std::memcmp(right.data(), source.last_right.data(), right.size_bytes()) != 0) {
+    return false;
+  }
+
+  // Same rate means the segments vector has the same size. So this copy does not allocate.
+
+  frontend = source.frontend;
+
+  blocks_before_cycle = source.blocks_before_cycle;
+
+  // Only the gating blocks closed in this cycle are new to us
+
+  blocks_consumed = blocks_before_cycle;
+
+  last_left.assign(left.begin(), left.end());
+  last_right.assign(right.begin(), right.end());
+
+  last_cycle = cycle;
+
+  consume_blocks();
+
+  return true;
+}
+
+void LoudnessAnalyzer::filter_samples(std::span<const float> left, std::span<const float> right) {
+  auto& pre = frontend.pre_filter_state;
+  auto& rlb = frontend.rlb_filter_state;
+
+  double peak_L = 0.0;
+  double peak_R = 0.0;
+
+  for (size_t n = 0U; n < left.size(); n++) {
+    const v2d x = {left[n], right[n]};
+
+    // Both channels are filtered at once. Transposed direct form II.
+
+    const v2d y1 = pre_b[0] * x + pre[0];
+
+    pre[0] = pre_b[1] * x - pre_a[1] * y1 + pre[1];
+    pre[1] = pre_b[2] * x - pre_a[2] * y1;
+
+    const v2d y = rlb_b[0] * y1 + rlb[0];
+
+    rlb[0] = rlb_b[1] * y1 - rlb_a[1] * y + rlb[1];
+    rlb[1] = rlb_b[2] * y1 - rlb_a[2] * y;
+
+    const v2d energy = y * y;
+
+    frontend.segment_energy += energy[0] + energy[1];
+
+    peak_L = std::max(peak_L, std::fabs(x[0]));
+    peak_R = std::max(peak_R, std::fabs(x[1]));
+
+    if (++frontend.segment_position == segment_size) {
+      close_segment();
+    }
+  }
+
+  frontend.sample_peak = {peak_L, peak_R};
+
+  frontend.true_peak[0] = std::max(frontend.true_peak[0], peak_L);
+  frontend.true_peak[1] = std::max(frontend.true_peak[1], peak_R);
+}
+
+void LoudnessAnalyzer::close_segment() {
+  const auto mean = std::min(frontend.segment_energy / static_cast<double>(segment_size), maximum_segment_energy);
+
+  const auto value = static_cast<int64_t>(mean * fixed_point_scale + 0.5);
+
+  auto& segments = frontend.segments;
+
+  // the ring holds the last 3 seconds. The momentary window is a part of it.
+
+  const auto position = frontend.n_segments % shortterm_segments;
+
+  const auto leaving_momentary = segments[(position + shortterm_segments - momentary_segments) % shortterm_segments];
+
+  frontend.momentary_sum += value - leaving_momentary;
+  frontend.shortterm_sum += value - segments[position];
+
+  segments[position] = value;
+
+  frontend.n_segments++;
+
+  frontend.segment_energy = 0.0;
+  frontend.segment_position = 0U;
+
+  // Flushing denormals that the filters would otherwise produce during silence
+
+  for (auto* state : {&frontend.pre_filter_state, &frontend.rlb_filter_state}) {
+    for (auto& s : *state) {
+      s = (s * s < v2d{1e-30, 1e-30}) ? v2d{0.0, 0.0} : s;
+    }
+  }
+
+  if (frontend.n_segments % block_segments != 0U || frontend.n_segments < momentary_segments) {
+    return;
+  }
+
+  auto& block = frontend.blocks[frontend.n_blocks % n_blocks_kept];
+
+  block.momentary_energy = static_cast<double>(frontend.momentary_sum) / (fixed_point_scale * momentary_segments);
+
+  block.has_shortterm = frontend.n_segments >= shortterm_segments;
+
+  block.shortterm_energy = static_cast<double>(frontend.shortterm_sum) / (fixed_point_scale * shortterm_segments);
+
+  frontend.n_blocks++;
+}
+
+void LoudnessAnalyzer::update_true_peak(std::span<const float> left, std::span<const float> right) {
+  const std::array<std::span<const float>, 2U> channels = {left, right};
+
+  const auto start_position = frontend.true_peak_position;
+
+  for (size_t c = 0U; c < channels.size(); c++) {
+    auto& history = frontend.true_peak_history[c];
+
+    auto position = start_position;
+
+    v4f peak = {0.0F, 0.0F, 0.0F, 0.0F};
+
+    for (const auto& sample : channels[c]) {
+      // The history is stored twice so that the newest n_taps_per_phase samples are always contiguous
+
+      position = (position == 0U) ? n_taps_per_phase - 1U : position - 1U;
+
+      history[position] = sample;
+      history[position + n_taps_per_phase] = sample;
+
+      v4f acc = {0.0F, 0.0F, 0.0F, 0.0F};
+
+      for (uint t = 0U; t < n_taps_per_phase; t++) {
+        acc += true_peak_coefficients[t] * history[position + t];
+      }
+
+      acc *= acc;
+
+      peak = (acc > peak) ? acc : peak;
+    }
+
+    const auto max_square = std::max({peak[0], peak[1], peak[2], peak[3]});
+
+    frontend.true_peak[c] = std::max(frontend.true_peak[c], static_cast<double>(std::sqrt(max_square)));
+
+    if (c + 1U == channels.size()) {
+      frontend.true_peak_position = position;
+    }
+  }
+}
+
+void LoudnessAnalyzer::consume_blocks() {
+  if (frontend.n_blocks - blocks_consumed > n_blocks_kept) {
+    blocks_consumed = frontend.n_blocks - n_blocks_kept;
+  }
+
+  for (; blocks_consumed < frontend.n_blocks; blocks_consumed++) {
+    const auto& block = frontend.blocks[blocks_consumed % n_blocks_kept];
+
+    integrated_histogram.add(block.momentary_energy);
+
+    if (block.has_shortterm) {
+      range_histogram.add(block.shortterm_energy);
+    }
+
+    gating_changed = true;
+  }
+}
+
+void LoudnessAnalyzer::update_gated_measures() {
+  if (!gating_changed) {
+    return;
+  }
+
+  gating_changed = false;
+
+  // integrated loudness
+
+  const auto [absolute_energy, n_absolute] = integrated_histogram.gated_energy(absolute_gate);
+
+  if (n_absolute == 0U) {
+    cached_relative = absolute_gate;
+    cached_integrated = -HUGE_VAL;
+  } else {
+    cached_relative = energy_to_loudness(absolute_energy) + relative_gate;
+
+    const auto [energy, n_blocks] = integrated_histogram.gated_energy(cached_relative);
+
+    cached_integrated = (n_blocks != 0U) ? energy_to_loudness(energy) : -HUGE_VAL;
+  }
+
+  // loudness range as defined in EBU Tech 3342
+
+  const auto [shortterm_energy, n_shortterm] = range_histogram.gated_energy(absolute_gate);
+
+  if (n_shortterm == 0U) {
+    cached_range = 0.0;
+  } else {
+    const auto threshold = energy_to_loudness(shortterm_energy) + range_relative_gate;
+
+    cached_range =
+        range_histogram.percentile_loudness(threshold, 0.95) - range_histogram.percentile_loudness(threshold, 0.10);
+  }
+}
+
+auto LoudnessAnalyzer::momentary() const -> double {
+  return energy_to_loudness(static_cast<double>(frontend.momentary_sum) / (fixed_point_scale * momentary_segments));
+}
+
+auto LoudnessAnalyzer::shortterm() const -> double {
+  return energy_to_loudness(static_cast<double>(frontend.shortterm_sum) / (fixed_point_scale * shortterm_segments));
+}
+
+auto LoudnessAnalyzer::integrated() -> double {
+  update_gated_measures();
+
+  return cached_integrated;
+}
+
+auto LoudnessAnalyzer::relative_threshold() -> double {
+  update_gated_measures();
+
+  return cached_relative;
+}
+
+auto LoudnessAnalyzer::range() -> double {
+  update_gated_measures();
+
+  return cached_range;
+}
+
+auto LoudnessAnalyzer::true_peak(const uint& channel) const -> double {
+  return frontend.true_peak[std::min(channel, 1U)];
+}
+
+auto LoudnessAnalyzer::previous_sample_peak(const uint& channel) const -> double {
+  return frontend.sample_peak[std::min(channel, 1U)];
+}
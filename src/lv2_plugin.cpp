@@ -0,0 +1,365 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lv2_plugin.hpp"
+
+Lv2Plugin::Lv2Plugin(const std::string& tag,
+                     const std::string& schema,
+                     const std::string& schema_path,
+                     PipeManager* pipe_manager)
+    : PluginBase(tag, tags::plugin_name::lv2_plugin, tags::plugin_package::lv2, schema, schema_path, pipe_manager) {
+  load_plugin();
+
+  gconnections.push_back(g_signal_connect(settings, "changed::plugin-uri",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<Lv2Plugin*>(user_data);
+
+                                            self->load_plugin();
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::control-values",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<Lv2Plugin*>(user_data);
+
+                                            self->apply_control_values(self->lv2_wrapper.get());
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::state",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<Lv2Plugin*>(user_data);
+
+                                            self->load_saved_state();
+                                          }),
+                                          this));
+
+  setup_input_output_gain();
+}
+
+Lv2Plugin::~Lv2Plugin() {
+  if (connected_to_pw) {
+    disconnect_from_pw();
+  }
+
+  util::debug(log_tag + name + " destroyed");
+}
+
+void Lv2Plugin::load_plugin(const bool& reload) {
+  const auto uri = util::gsettings_get_string(settings, "plugin-uri");
+
+  if (uri == plugin_uri && lv2_wrapper != nullptr && !reload) {
+    return;
+  }
+
+  plugin_uri = uri;
+
+  std::unique_ptr<lv2::Lv2Wrapper> wrapper;
+
+  if (!uri.empty()) {
+    if (const auto* info = lv2::World::get().find_plugin_info(uri); info == nullptr) {
+      util::warning(log_tag + uri + " is not installed");
+    } else if (info->n_audio_in != 2U || info->n_audio_out != 2U) {
+      util::warning(log_tag + uri + " is not a stereo plugin");
+    } else {
+      wrapper = std::make_unique<lv2::Lv2Wrapper>(uri);
+    }
+  }
+
+  lv2::ControlPort new_latency_port;
+
+  if (wrapper != nullptr) {
+    for (const auto& p : wrapper->get_ports()) {
+      if (p.type == lv2::TYPE_CONTROL && !p.is_input && p.reports_latency) {
+        new_latency_port = wrapper->find_control_port(p.symbol);
+
+        break;
+      }
+    }
+
+    // The saved state is restored into the new instance before it is activated
+
+    wrapper->set_state(get_saved_state());
+
+    // The new instance is created here. So the realtime thread keeps using the old one until the swap.
+
+    if (rate != 0U) {
+      wrapper->set_n_samples(n_samples);
+
+      wrapper->prepare_instance(rate);
+    }
+
+    // committed now the saved values are applied before the first block the new instance runs
+
+    apply_control_values(wrapper.get());
+
+    wrapper->commit_control_port_values();
+  }
+
+  if (lv2_wrapper != nullptr) {
+    lv2_wrapper->close_ui();
+  }
+
+  {
+    std::scoped_lock<std::mutex> lock(data_mutex);
+
+    lv2_wrapper.swap(wrapper);
+
+    latency_port = new_latency_port;
+
+    // The rate and the quantum were read without the lock. The filter may have changed them since then.
+
+    if (lv2_wrapper != nullptr && rate != 0U) {
+      lv2_wrapper->set_n_samples(n_samples);
+
+      if (lv2_wrapper->get_rate() != rate) {
+        lv2_wrapper->create_instance(rate);
+      }
+    }
+  }
+
+  // the old wrapper is destroyed outside of the lock
+
+  wrapper.reset();
+
+  plugin_changed.emit();
+}
+
+void Lv2Plugin::apply_control_values(lv2::Lv2Wrapper* wrapper) {
+  if (wrapper == nullptr) {
+    return;
+  }
+
+  GVariant* dict = g_settings_get_value(settings, "control-values");
+
+  std::vector<lv2::PortValue> values;
+
+  for (const auto& p : wrapper->get_ports()) {
+    if (p.type != lv2::TYPE_CONTROL || !p.is_input) {
+      continue;
+    }
+
+    // the ports without a saved value use their default
+
+    double v = p.value;
+
+    g_variant_lookup(dict, p.symbol.c_str(), "d", &v);
+
+    values.push_back({.port = wrapper->find_control_port(p.symbol), .value = static_cast<float>(v)});
+  }
+
+  g_variant_unref(dict);
+
+  wrapper->set_control_port_values(values);
+}
+
+auto Lv2Plugin::get_controls() const -> std::vector<lv2::Port> {
+  std::vector<lv2::Port> controls;
+
+  if (lv2_wrapper == nullptr) {
+    return controls;
+  }
+
+  const auto* info = lv2::World::get().find_plugin_info(plugin_uri);
+
+  if (info == nullptr) {
+    return controls;
+  }
+
+  std::ranges::copy_if(info->ports, std::back_inserter(controls),
+                       [](const auto& p) { return p.type == lv2::TYPE_CONTROL && p.is_input; });
+
+  return controls;
+}
+
+void Lv2Plugin::save_control_values() {
+  if (lv2_wrapper == nullptr) {
+    return;
+  }
+
+  GVariantBuilder builder;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sd}"));
+
+  for (const auto& p : lv2_wrapper->get_ports()) {
+    if (p.type == lv2::TYPE_CONTROL && p.is_input) {
+      g_variant_builder_add(&builder, "{sd}", p.symbol.c_str(),
+                            static_cast<double>(lv2_wrapper->get_control_port_value(p.symbol)));
+    }
+  }
+
+  GVariant* dict = g_variant_ref_sink(g_variant_builder_end(&builder));
+  GVariant* current = g_settings_get_value(settings, "control-values");
+
+  if (g_variant_equal(dict, current) == 0) {
+    g_settings_set_value(settings, "control-values", dict);
+  }
+
+  g_variant_unref(current);
+  g_variant_unref(dict);
+
+  save_state();
+}
+
+auto Lv2Plugin::get_saved_state() const -> std::vector<lv2::StateProperty> {
+  std::vector<lv2::StateProperty> properties;
+
+  GVariant* array = g_settings_get_value(settings, "state");
+
+  GVariantIter iter;
+  const gchar* key = nullptr;
+  const gchar* type = nullptr;
+  guint32 flags = 0U;
+  GVariant* value = nullptr;
+
+  g_variant_iter_init(&iter, array);
+
+  while (g_variant_iter_next(&iter, "(&s&su@ay)", &key, &type, &flags, &value) != 0) {
+    gsize size = 0U;
+
+    const auto* data = static_cast<const uint8_t*>(g_variant_get_fixed_array(value, &size, sizeof(uint8_t)));
+
+    properties.push_back({.key = key, .type = type, .flags = flags, .value = std::vector<uint8_t>(data, data + size)});
+
+    g_variant_unref(value);
+  }
+
+  g_variant_unref(array);
+
+  return properties;
+}
+
+void Lv2Plugin::load_saved_state() {
+  if (lv2_wrapper == nullptr || util::gsettings_get_string(settings, "plugin-uri") != plugin_uri) {
+    return;
+  }
+
+  if (lv2_wrapper->get_state() != get_saved_state()) {
+    load_plugin(true);
+  }
+}
+
+void Lv2Plugin::save_state() {
+  std::vector<lv2::StateProperty> properties;
+
+  {
+    // the state is not saved while run() is running
+
+    std::scoped_lock<std::mutex> lock(data_mutex);
+
+    properties = lv2_wrapper->save_state();
+  }
+
+  GVariantBuilder builder;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ssuay)"));
+
+  for (const auto& p : properties) {
+    auto* value = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, p.value.data(), p.value.size(), sizeof(uint8_t));
+
+    g_variant_builder_add(&builder, "(ssu@ay)", p.key.c_str(), p.type.c_str(), p.flags, value);
+  }
+
+  GVariant* array = g_variant_ref_sink(g_variant_builder_end(&builder));
+  GVariant* current = g_settings_get_value(settings, "state");
+
+  if (g_variant_equal(array, current) == 0) {
+    // the next instances this wrapper prepares for a new rate start from the same state
+
+    lv2_wrapper->set_state(properties);
+
+    g_settings_set_value(settings, "state", array);
+  }
+
+  g_variant_unref(current);
+  g_variant_unref(array);
+}
+
+void Lv2Plugin::setup() {
+  std::scoped_lock<std::mutex> lock(data_mutex);
+
+  if (lv2_wrapper == nullptr || !lv2_wrapper->found_plugin) {
+    return;
+  }
+
+  lv2_wrapper->set_n_samples(n_samples);
+
+  if (lv2_wrapper->get_rate() != rate) {
+    lv2_wrapper->create_instance(rate);
+  }
+}
+
+void Lv2Plugin::process(std::span<float>& left_in,
+                        std::span<float>& right_in,
+                        std::span<float>& left_out,
+                        std::span<float>& right_out) {
+  std::scoped_lock<std::mutex> lock(data_mutex);
+
+  if (lv2_wrapper == nullptr || !lv2_wrapper->has_instance() || bypass) {
+    std::copy(left_in.begin(), left_in.end(), left_out.begin());
+    std::copy(right_in.begin(), right_in.end(), right_out.begin());
+
+    return;
+  }
+
+  if (input_gain != 1.0F) {
+    apply_gain(left_in, right_in, input_gain);
+  }
+
+  lv2_wrapper->connect_data_ports(left_in, right_in, left_out, right_out);
+  lv2_wrapper->run();
+
+  if (output_gain != 1.0F) {
+    apply_gain(left_out, right_out, output_gain);
+  }
+
+  // lv2 plugins report their latency in number of samples
+
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
+
+  if (latency_n_frames != lv) {
+    latency_n_frames = lv;
+
+    latency_value = static_cast<float>(latency_n_frames) / static_cast<float>(rate);
+
+    util::debug(log_tag + name + " latency: " + util::to_string(latency_value, "") + " s");
+
+    util::idle_add([=, this]() {
+      if (!post_messages || latency.empty()) {
+        return;
+      }
+
+      latency.emit();
+    });
+
+    update_filter_params();
+  }
+
+  if (post_messages) {
+    get_peaks(left_in, right_in, left_out, right_out);
+
+    if (send_notifications) {
+      notify();
+    }
+  }
+}
+
+auto Lv2Plugin::get_latency_seconds() -> float {
+  return latency_value;
+}
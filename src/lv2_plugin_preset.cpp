@@ -0,0 +1,153 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lv2_plugin_preset.hpp"
+
+Lv2PluginPreset::Lv2PluginPreset(PresetType preset_type, const int& index)
+    : PluginPresetBase(tags::schema::lv2_plugin::id,
+                       tags::schema::lv2_plugin::input_path,
+                       tags::schema::lv2_plugin::output_path,
+                       preset_type,
+                       index) {
+  instance_name.assign(tags::plugin_name::lv2_plugin).append("#").append(util::to_string(index));
+}
+
+void Lv2PluginPreset::save(nlohmann::json& json) {
+  json[section][instance_name]["bypass"] = g_settings_get_boolean(settings, "bypass") != 0;
+
+  json[section][instance_name]["input-gain"] = g_settings_get_double(settings, "input-gain");
+
+  json[section][instance_name]["output-gain"] = g_settings_get_double(settings, "output-gain");
+
+  json[section][instance_name]["plugin-uri"] = util::gsettings_get_string(settings, "plugin-uri");
+
+  // the control values are saved by port symbol
+
+  auto& controls = json[section][instance_name]["control-values"];
+
+  controls = nlohmann::json::object();
+
+  GVariant* dict = g_settings_get_value(settings, "control-values");
+
+  GVariantIter iter;
+
+  const gchar* symbol = nullptr;
+
+  double value = 0.0;
+
+  g_variant_iter_init(&iter, dict);
+
+  while (g_variant_iter_next(&iter, "{&sd}", &symbol, &value) != 0) {
+    controls[symbol] = value;
+  }
+
+  g_variant_unref(dict);
+
+  // the plain old data state of the plugin. The values are encoded in base64.
+
+  auto& state = json[section][instance_name]["state"];
+
+  state = nlohmann::json::array();
+
+  GVariant* array = g_settings_get_value(settings, "state");
+
+  const gchar* key = nullptr;
+  const gchar* type = nullptr;
+  guint32 flags = 0U;
+  GVariant* bytes = nullptr;
+
+  g_variant_iter_init(&iter, array);
+
+  while (g_variant_iter_next(&iter, "(&s&su@ay)", &key, &type, &flags, &bytes) != 0) {
+    gsize size = 0U;
+
+    const auto* data = static_cast<const guchar*>(g_variant_get_fixed_array(bytes, &size, sizeof(guchar)));
+
+    gchar* encoded = g_base64_encode(data, size);
+
+    state.push_back({{"key", key}, {"type", type}, {"flags", flags}, {"value", encoded}});
+
+    g_free(encoded);
+
+    g_variant_unref(bytes);
+  }
+
+  g_variant_unref(array);
+}
+
+void Lv2PluginPreset::load(const nlohmann::json& json) {
+  update_key<bool>(json.at(section).at(instance_name), settings, "bypass", "bypass");
+
+  update_key<double>(json.at(section).at(instance_name), settings, "input-gain", "input-gain");
+
+  update_key<double>(json.at(section).at(instance_name), settings, "output-gain", "output-gain");
+
+  update_key<gchar*>(json.at(section).at(instance_name), settings, "plugin-uri", "plugin-uri");
+
+  GVariantBuilder builder;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sd}"));
+
+  const auto controls = json.at(section).at(instance_name).value("control-values", nlohmann::json::object());
+
+  for (const auto& [symbol, value] : controls.items()) {
+    g_variant_builder_add(&builder, "{sd}", symbol.c_str(), value.get<double>());
+  }
+
+  GVariant* new_dict = g_variant_ref_sink(g_variant_builder_end(&builder));
+
+  GVariant* dict = g_settings_get_value(settings, "control-values");
+
+  if (g_variant_equal(dict, new_dict) == 0) {
+    g_settings_set_value(settings, "control-values", new_dict);
+  }
+
+  g_variant_unref(dict);
+  g_variant_unref(new_dict);
+
+  // Set after the plugin uri. So the state is restored into an instance of the plugin that saved it.
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ssuay)"));
+
+  const auto state = json.at(section).at(instance_name).value("state", nlohmann::json::array());
+
+  for (const auto& p : state) {
+    gsize size = 0U;
+
+    guchar* data = g_base64_decode(p.value("value", "").c_str(), &size);
+
+    auto* bytes = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data, size, sizeof(guchar));
+
+    g_free(data);
+
+    g_variant_builder_add(&builder, "(ssu@ay)", p.value("key", "").c_str(), p.value("type", "").c_str(),
+                          p.value("flags", 0U), bytes);
+  }
+
+  GVariant* new_state = g_variant_ref_sink(g_variant_builder_end(&builder));
+
+  GVariant* current_state = g_settings_get_value(settings, "state");
+
+  if (g_variant_equal(current_state, new_state) == 0) {
+    g_settings_set_value(settings, "state", new_state);
+  }
+
+  g_variant_unref(current_state);
+  g_variant_unref(new_state);
+}
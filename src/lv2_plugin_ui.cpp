@@ -0,0 +1,434 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lv2_plugin_ui.hpp"
+
+namespace ui::lv2_plugin_box {
+
+struct Control {
+  std::string symbol;
+
+  float default_value = 0.0F;
+
+  GtkWidget* widget = nullptr;  // a GtkSwitch for toggled ports and a GtkSpinButton for the others
+};
+
+struct Data {
+ public:
+  ~Data() { util::debug("data struct destroyed"); }
+
+  uint serial = 0U;
+
+  bool updating = false;  // true while the widgets are updated from gsettings
+
+  std::shared_ptr<Lv2Plugin> lv2_plugin;
+
+  std::vector<std::string> plugin_uris;  // in the same order as the names in the drop down
+
+  std::vector<Control> controls;
+
+  std::vector<GtkWidget*> control_rows;
+
+  std::vector<sigc::connection> connections;
+
+  std::vector<gulong> gconnections;
+};
+
+struct _Lv2PluginBox {
+  GtkBox parent_instance;
+
+  GtkScale *input_gain, *output_gain;
+
+  GtkLevelBar *input_level_left, *input_level_right, *output_level_left, *output_level_right;
+
+  GtkLabel *input_level_left_label, *input_level_right_label, *output_level_left_label, *output_level_right_label,
+      *plugin_credit;
+
+  GtkDropDown* plugin_list;
+
+  GtkStringList* plugin_names;
+
+  AdwPreferencesGroup* controls;
+
+  GtkToggleButton* show_native_ui;
+
+  GSettings* settings;
+
+  Data* data;
+};
+
+// NOLINTNEXTLINE
+G_DEFINE_TYPE(Lv2PluginBox, lv2_plugin_box, GTK_TYPE_BOX)
+
+void on_reset(Lv2PluginBox* self, GtkButton* btn) {
+  util::reset_all_keys_except(self->settings, {"plugin-uri"});
+}
+
+void on_show_native_window(Lv2PluginBox* self, GtkToggleButton* btn) {
+  if (gtk_toggle_button_get_active(btn) != 0) {
+    self->data->lv2_plugin->show_native_ui();
+  } else {
+    self->data->lv2_plugin->close_native_ui();
+
+    self->data->lv2_plugin->save_control_values();
+  }
+}
+
+void set_control_value(Lv2PluginBox* self, const std::string& symbol, const double& value) {
+  // the values of the other ports are kept
+
+  GVariant* current = g_settings_get_value(self->settings, "control-values");
+
+  GVariantBuilder builder;
+  GVariantIter iter;
+
+  const char* key = nullptr;
+  double v = 0.0;
+
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sd}"));
+
+  g_variant_iter_init(&iter, current);
+
+  while (g_variant_iter_next(&iter, "{&sd}", &key, &v) != 0) {
+    if (symbol != key) {
+      g_variant_builder_add(&builder, "{sd}", key, v);
+    }
+  }
+
+  g_variant_builder_add(&builder, "{sd}", symbol.c_str(), value);
+
+  g_settings_set_value(self->settings, "control-values", g_variant_builder_end(&builder));
+
+  g_variant_unref(current);
+}
+
+void update_controls(Lv2PluginBox* self) {
+  GVariant* dict = g_settings_get_value(self->settings, "control-values");
+
+  self->data->updating = true;
+
+  for (const auto& c : self->data->controls) {
+    // the ports without a saved value use their default
+
+    double v = c.default_value;
+
+    g_variant_lookup(dict, c.symbol.c_str(), "d", &v);
+
+    if (GTK_IS_SWITCH(c.widget)) {
+      gtk_switch_set_active(GTK_SWITCH(c.widget), (v > 0.0) ? 1 : 0);
+    } else {
+      gtk_spin_button_set_value(GTK_SPIN_BUTTON(c.widget), v);
+    }
+  }
+
+  self->data->updating = false;
+
+  g_variant_unref(dict);
+}
+
+void build_controls(Lv2PluginBox* self) {
+  for (auto* row : self->data->control_rows) {
+    adw_preferences_group_remove(self->controls, row);
+  }
+
+  self->data->control_rows.clear();
+  self->data->controls.clear();
+
+  const auto ports = self->data->lv2_plugin->get_controls();
+
+  gtk_widget_set_visible(GTK_WIDGET(self->controls), ports.empty() ? 0 : 1);
+
+  for (const auto& p : ports) {
+    auto* row = adw_action_row_new();
+
+    adw_preferences_row_set_title(ADW_PREFERENCES_ROW(row), p.name.c_str());
+
+    GtkWidget* widget = nullptr;
+
+    if (p.toggled) {
+      widget = gtk_switch_new();
+
+      g_signal_connect(widget, "notify::active",
+                       G_CALLBACK(+[](GtkSwitch* btn, GParamSpec* pspec, Lv2PluginBox* self) {
+                         if (self->data->updating) {
+                           return;
+                         }
+
+                         const auto* symbol = static_cast<const char*>(g_object_get_data(G_OBJECT(btn), "symbol"));
+
+                         set_control_value(self, symbol, (gtk_switch_get_active(btn) != 0) ? 1.0 : 0.0);
+                       }),
+                       self);
+    } else {
+      // some plugins do not declare a range
+
+      const auto min = static_cast<double>(p.min);
+      const auto max = (p.max > p.min) ? static_cast<double>(p.max) : min + 1.0;
+
+      widget = gtk_spin_button_new_with_range(min, max, p.integer ? 1.0 : (max - min) / 100.0);
+
+      gtk_spin_button_set_digits(GTK_SPIN_BUTTON(widget), p.integer ? 0U : 3U);
+
+      g_signal_connect(widget, "value-changed", G_CALLBACK(+[](GtkSpinButton* btn, Lv2PluginBox* self) {
+                         if (self->data->updating) {
+                           return;
+                         }
+
+                         const auto* symbol = static_cast<const char*>(g_object_get_data(G_OBJECT(btn), "symbol"));
+
+                         set_control_value(self, symbol, gtk_spin_button_get_value(btn));
+                       }),
+                       self);
+    }
+
+    gtk_widget_set_valign(widget, GTK_ALIGN_CENTER);
+
+    g_object_set_data_full(G_OBJECT(widget), "symbol", g_strdup(p.symbol.c_str()), g_free);
+
+    adw_action_row_add_suffix(ADW_ACTION_ROW(row), widget);
+
+    adw_preferences_group_add(self->controls, row);
+
+    self->data->control_rows.push_back(row);
+
+    self->data->controls.push_back({.symbol = p.symbol, .default_value = p.value, .widget = widget});
+  }
+
+  update_controls(self);
+}
+
+void select_plugin(Lv2PluginBox* self) {
+  const auto uri = util::gsettings_get_string(self->settings, "plugin-uri");
+
+  const auto& uris = self->data->plugin_uris;
+
+  const auto it = std::ranges::find(uris, uri);
+
+  self->data->updating = true;
+
+  gtk_drop_down_set_selected(self->plugin_list, (it != uris.end()) ? static_cast<guint>(std::distance(uris.begin(), it))
+                                                                   : GTK_INVALID_LIST_POSITION);
+
+  self->data->updating = false;
+
+  // the credit shows the plugin in use
+
+  const auto* name =
+      (it != uris.end() && !uri.empty())
+          ? gtk_string_list_get_string(self->plugin_names, static_cast<guint>(std::distance(uris.begin(), it)))
+          : self->data->lv2_plugin->package.c_str();
+
+  gtk_label_set_text(self->plugin_credit, ui::get_plugin_credit_translated(name).c_str());
+}
+
+void setup_plugin_list(Lv2PluginBox* self) {
+  self->data->plugin_uris.emplace_back("");
+
+  gtk_string_list_append(self->plugin_names, _("None"));
+
+  for (const auto& [uri, name] : lv2::World::get().list_stereo_plugins()) {
+    self->data->plugin_uris.push_back(uri);
+
+    gtk_string_list_append(self->plugin_names, name.c_str());
+  }
+
+  g_signal_connect(self->plugin_list, "notify::selected",
+                   G_CALLBACK(+[](GtkDropDown* dropdown, GParamSpec* pspec, Lv2PluginBox* self) {
+                     if (self->data->updating) {
+                       return;
+                     }
+
+                     const auto n = gtk_drop_down_get_selected(dropdown);
+
+                     if (n >= self->data->plugin_uris.size()) {
+                       return;
+                     }
+
+                     const auto& uri = self->data->plugin_uris[n];
+
+                     if (uri == util::gsettings_get_string(self->settings, "plugin-uri")) {
+                       return;
+                     }
+
+                     /*
+                       The values and the state of the previous plugin do not make sense for the new one. They are
+                       applied together so that the new plugin is loaded only once.
+                     */
+
+                     g_settings_delay(self->settings);
+
+                     g_settings_reset(self->settings, "control-values");
+
+                     g_settings_reset(self->settings, "state");
+
+                     g_settings_set_string(self->settings, "plugin-uri", uri.c_str());
+
+                     g_settings_apply(self->settings);
+                   }),
+                   self);
+}
+
+void setup(Lv2PluginBox* self, std::shared_ptr<Lv2Plugin> lv2_plugin, const std::string& schema_path) {
+  self->data->lv2_plugin = lv2_plugin;
+
+  auto serial = get_new_filter_serial();
+
+  self->data->serial = serial;
+
+  g_object_set_data(G_OBJECT(self), "serial", GUINT_TO_POINTER(serial));
+
+  set_ignore_filter_idle_add(serial, false);
+
+  self->settings = g_settings_new_with_path(tags::schema::lv2_plugin::id, schema_path.c_str());
+
+  lv2_plugin->set_post_messages(true);
+
+  self->data->connections.push_back(lv2_plugin->input_level.connect([=](const float left, const float right) {
+    util::idle_add([=]() {
+      if (get_ignore_filter_idle_add(serial)) {
+        return;
+      }
+
+      update_level(self->input_level_left, self->input_level_left_label, self->input_level_right,
+                   self->input_level_right_label, left, right);
+    });
+  }));
+
+  self->data->connections.push_back(lv2_plugin->output_level.connect([=](const float left, const float right) {
+    util::idle_add([=]() {
+      if (get_ignore_filter_idle_add(serial)) {
+        return;
+      }
+
+      update_level(self->output_level_left, self->output_level_left_label, self->output_level_right,
+                   self->output_level_right_label, left, right);
+    });
+  }));
+
+  // The plugin is loaded in the main thread. So the widgets can be rebuilt right away.
+
+  self->data->connections.push_back(lv2_plugin->plugin_changed.connect([=]() {
+    gtk_toggle_button_set_active(self->show_native_ui, 0);
+
+    select_plugin(self);
+
+    build_controls(self);
+  }));
+
+  self->data->gconnections.push_back(g_signal_connect(
+      self->settings, "changed::control-values",
+      G_CALLBACK(+[](GSettings* settings, char* key, Lv2PluginBox* self) { update_controls(self); }), self));
+
+  setup_plugin_list(self);
+
+  select_plugin(self);
+
+  build_controls(self);
+
+  gsettings_bind_widgets<"input-gain", "output-gain">(self->settings, self->input_gain, self->output_gain);
+
+  g_settings_bind(ui::get_global_app_settings(), "show-native-plugin-ui", self->show_native_ui, "visible",
+                  G_SETTINGS_BIND_DEFAULT);
+}
+
+void dispose(GObject* object) {
+  auto* self = EE_LV2_PLUGIN_BOX(object);
+
+  self->data->lv2_plugin->set_post_messages(false);
+
+  if (gtk_toggle_button_get_active(self->show_native_ui) != 0) {
+    self->data->lv2_plugin->close_native_ui();
+
+    self->data->lv2_plugin->save_control_values();
+  }
+
+  set_ignore_filter_idle_add(self->data->serial, true);
+
+  for (auto& c : self->data->connections) {
+    c.disconnect();
+  }
+
+  for (auto& handler_id : self->data->gconnections) {
+    g_signal_handler_disconnect(self->settings, handler_id);
+  }
+
+  self->data->connections.clear();
+  self->data->gconnections.clear();
+
+  g_object_unref(self->settings);
+
+  util::debug("disposed");
+
+  G_OBJECT_CLASS(lv2_plugin_box_parent_class)->dispose(object);
+}
+
+void finalize(GObject* object) {
+  auto* self = EE_LV2_PLUGIN_BOX(object);
+
+  delete self->data;
+
+  util::debug("finalized");
+
+  G_OBJECT_CLASS(lv2_plugin_box_parent_class)->finalize(object);
+}
+
+void lv2_plugin_box_class_init(Lv2PluginBoxClass* klass) {
+  auto* object_class = G_OBJECT_CLASS(klass);
+  auto* widget_class = GTK_WIDGET_CLASS(klass);
+
+  object_class->dispose = dispose;
+  object_class->finalize = finalize;
+
+  gtk_widget_class_set_template_from_resource(widget_class, tags::resources::lv2_plugin_ui);
+
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, input_gain);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, output_gain);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, input_level_left);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, input_level_right);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, output_level_left);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, output_level_right);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, input_level_left_label);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, input_level_right_label);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, output_level_left_label);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, output_level_right_label);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, plugin_credit);
+
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, plugin_list);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, plugin_names);
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, controls);
+
+  gtk_widget_class_bind_template_child(widget_class, Lv2PluginBox, show_native_ui);
+
+  gtk_widget_class_bind_template_callback(widget_class, on_reset);
+  gtk_widget_class_bind_template_callback(widget_class, on_show_native_window);
+}
+
+void lv2_plugin_box_init(Lv2PluginBox* self) {
+  gtk_widget_init_template(GTK_WIDGET(self));
+
+  self->data = new Data();
+
+  prepare_scales<"dB">(self->input_gain, self->output_gain);
+}
+
+auto create() -> Lv2PluginBox* {
+  return static_cast<Lv2PluginBox*>(g_object_new(EE_TYPE_LV2_PLUGIN_BOX, nullptr));
+}
+
+}  // namespace ui::lv2_plugin_box
@@ -0,0 +1,195 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lv2_worker.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include "util.hpp"
+
+namespace lv2 {
+
+Worker::Worker()
+    : requests(ring_size), responses(ring_size), request_data(ring_size), response_data(ring_size) {
+  schedule_data = {this, [](LV2_Worker_Schedule_Handle handle, uint32_t size, const void* data) {
+                     return static_cast<Worker*>(handle)->schedule(size, data);
+                   }};
+}
+
+Worker::~Worker() {
+  stop();
+}
+
+void Worker::start(LilvInstance* instance) {
+  stop();
+
+  iface = static_cast<const LV2_Worker_Interface*>(lilv_instance_get_extension_data(instance, LV2_WORKER__interface));
+
+  if (iface == nullptr || iface->work == nullptr) {
+    iface = nullptr;
+
+    return;
+  }
+
+  handle = lilv_instance_get_handle(instance);
+
+  quit.store(false);
+
+  thread = std::thread([this]() { work(); });
+}
+
+void Worker::stop() {
+  if (!thread.joinable()) {
+    return;
+  }
+
+  quit.store(true);
+
+  requests_available.release();
+
+  thread.join();
+
+  // whatever was left belongs to the instance being freed
+
+  uint32_t size = 0U;
+
+  while (requests.read(size, request_data)) {
+  }
+
+  while (responses.read(size, response_data)) {
+  }
+
+  iface = nullptr;
+  handle = nullptr;
+}
+
+auto Worker::schedule(const uint32_t& size, const void* data) -> LV2_Worker_Status {
+  if (iface == nullptr) {
+    return LV2_WORKER_ERR_UNKNOWN;
+  }
+
+  if (!requests.write(size, data)) {
+    return LV2_WORKER_ERR_NO_SPACE;
+  }
+
+  requests_available.release();
+
+  return LV2_WORKER_SUCCESS;
+}
+
+void Worker::deliver_responses() {
+  if (iface == nullptr) {
+    return;
+  }
+
+  uint32_t size = 0U;
+
+  while (responses.read(size, response_data)) {
+    if (iface->work_response != nullptr) {
+      iface->work_response(handle, size, response_data.data());
+    }
+  }
+
+  if (iface->end_run != nullptr) {
+    iface->end_run(handle);
+  }
+}
+
+void Worker::work() {
+  while (true) {
+    requests_available.acquire();
+
+    if (quit.load()) {
+      break;
+    }
+
+    uint32_t size = 0U;
+
+    if (!requests.read(size, request_data)) {
+      continue;
+    }
+
+    iface->work(
+        handle,
+        [](LV2_Worker_Respond_Handle handle, uint32_t size, const void* data) {
+          if (!static_cast<Worker*>(handle)->responses.write(size, data)) {
+            util::warning("the lv2 worker response ring is full");
+
+            return LV2_WORKER_ERR_NO_SPACE;
+          }
+
+          return LV2_WORKER_SUCCESS;
+        },
+        this, size, request_data.data());
+  }
+}
+
+Worker::Ring::Ring(const size_t& size) : buffer(size) {}
+
+auto Worker::Ring::write(const uint32_t& size, const void* data) -> bool {
+  const auto w = write_position.load(std::memory_order_relaxed);
+  const auto r = read_position.load(std::memory_order_acquire);
+
+  if (buffer.size() - (w - r) < sizeof(size) + size) {
+    return false;
+  }
+
+  copy_in(w, &size, sizeof(size));
+  copy_in(w + sizeof(size), data, size);
+
+  write_position.store(w + sizeof(size) + size, std::memory_order_release);
+
+  return true;
+}
+
+auto Worker::Ring::read(uint32_t& size, std::vector<uint8_t>& data) -> bool {
+  const auto r = read_position.load(std::memory_order_relaxed);
+  const auto w = write_position.load(std::memory_order_acquire);
+
+  if (w == r) {
+    return false;
+  }
+
+  copy_out(r, &size, sizeof(size));
+  copy_out(r + sizeof(size), data.data(), size);  // a message is never bigger than the ring
+
+  read_position.store(r + sizeof(size) + size, std::memory_order_release);
+
+  return true;
+}
+
+void Worker::Ring::copy_in(const size_t& position, const void* data, const size_t& size) {
+  const auto offset = position % buffer.size();
+
+  const auto count = std::min(size, buffer.size() - offset);
+
+  std::memcpy(buffer.data() + offset, data, count);
+  std::memcpy(buffer.data(), static_cast<const uint8_t*>(data) + count, size - count);
+}
+
+void Worker::Ring::copy_out(const size_t& position, void* data, const size_t& size) const {
+  const auto offset = position % buffer.size();
+
+  const auto count = std::min(size, buffer.size() - offset);
+
+  std::memcpy(data, buffer.data() + offset, count);
+  std::memcpy(static_cast<uint8_t*>(data) + count, buffer.data(), size - count);
+}
+
+}  // namespace lv2
@@ -0,0 +1,415 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lv2_world.hpp"
+
+#include <lv2/atom/atom.h>
+#include <lv2/core/lv2.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "util.hpp"
+
+namespace lv2 {
+
+using namespace std::string_literals;
+
+namespace {
+
+// Increase it whenever the format of the cache file changes
+constexpr int cache_version = 2;
+
+}  // namespace
+
+World::World() : cache_file(g_get_user_cache_dir() + "/easyeffects/lv2_plugins.json"s) {
+  read_cache_file();
+}
+
+World::~World() {
+  if (loaded.valid()) {
+    loaded.wait();
+  }
+
+  if (world != nullptr) {
+    lilv_world_free(world);
+  }
+}
+
+auto World::get() -> World& {
+  static World instance;
+
+  return instance;
+}
+
+void World::load_async() {
+  std::call_once(load_flag, [this]() {
+    loaded = std::async(std::launch::async, [this]() {
+                           util::debug("loading the lv2 world");
+
+                           world = lilv_world_new();
+
+                           if (world == nullptr) {
+                             util::warning("failed to initialized the world");
+
+                             return;
+                           }
+
+                           lilv_world_load_all(world);
+
+                           util::debug("lv2 world loaded");
+
+                           util::idle_add([this]() {
+                             ready = true;
+
+                             world_loaded.emit();
+                           });
+                         }).share();
+  });
+}
+
+auto World::is_ready() const -> bool {
+  return ready;
+}
+
+auto World::get_world() -> LilvWorld* {
+  load_async();
+
+  loaded.wait();
+
+  return world;
+}
+
+auto World::find_plugin(const std::string& uri) -> const LilvPlugin* {
+  auto* w = get_world();
+
+  if (w == nullptr) {
+    return nullptr;
+  }
+
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  auto* node = lilv_new_uri(w, uri.c_str());
+
+  if (node == nullptr) {
+    util::warning("Invalid plugin URI: " + uri);
+
+    return nullptr;
+  }
+
+  const auto* plugin = lilv_plugins_get_by_uri(lilv_world_get_all_plugins(w), node);
+
+  lilv_node_free(node);
+
+  return plugin;
+}
+
+auto World::list_stereo_plugins() -> std::vector<PluginDescription> {
+  std::vector<PluginDescription> list;
+
+  auto* w = get_world();
+
+  if (w == nullptr) {
+    return list;
+  }
+
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  LilvNode* lv2_InputPort = lilv_new_uri(w, LV2_CORE__InputPort);
+  LilvNode* lv2_OutputPort = lilv_new_uri(w, LV2_CORE__OutputPort);
+  LilvNode* lv2_AudioPort = lilv_new_uri(w, LV2_CORE__AudioPort);
+
+  const auto* plugins = lilv_world_get_all_plugins(w);
+
+  LILV_FOREACH(plugins, i, plugins) {
+    const auto* plugin = lilv_plugins_get(plugins, i);
+
+    if (lilv_plugin_get_num_ports_of_class(plugin, lv2_AudioPort, lv2_InputPort, nullptr) != 2U ||
+        lilv_plugin_get_num_ports_of_class(plugin, lv2_AudioPort, lv2_OutputPort, nullptr) != 2U) {
+      continue;
+    }
+
+    auto* name = lilv_plugin_get_name(plugin);
+
+    list.push_back({.uri = lilv_node_as_uri(lilv_plugin_get_uri(plugin)),
+                    .name = (name != nullptr) ? lilv_node_as_string(name) : ""});
+
+    lilv_node_free(name);
+  }
+
+  lilv_node_free(lv2_AudioPort);
+  lilv_node_free(lv2_OutputPort);
+  lilv_node_free(lv2_InputPort);
+
+  std::ranges::sort(list, {}, &PluginDescription::name);
+
+  return list;
+}
+
+auto World::find_plugin_info(const std::string& uri) -> const PluginInfo* {
+  std::scoped_lock<std::mutex> lock(info_mutex);
+
+  if (const auto it = info_cache.find(uri); it != info_cache.end()) {
+    if (get_bundle_mtime(it->second.bundle_path) == it->second.bundle_mtime) {
+      return &it->second;
+    }
+
+    util::debug(uri + " bundle was modified. Its cached metadata will be updated");
+
+    info_cache.erase(it);
+  }
+
+  const auto* plugin = find_plugin(uri);
+
+  if (plugin == nullptr) {
+    return nullptr;
+  }
+
+  auto [it, inserted] = info_cache.insert_or_assign(uri, query_plugin_info(plugin));
+
+  write_cache_file();
+
+  return &it->second;
+}
+
+auto World::query_plugin_info(const LilvPlugin* plugin) -> PluginInfo {
+  std::scoped_lock<std::mutex> lock(mutex);
+
+  PluginInfo info;
+
+  const std::string plugin_uri = lilv_node_as_uri(lilv_plugin_get_uri(plugin));
+
+  if (auto* path = lilv_file_uri_parse(lilv_node_as_uri(lilv_plugin_get_bundle_uri(plugin)), nullptr)) {
+    info.bundle_path = path;
+
+    lilv_free(path);
+  }
+
+  info.bundle_mtime = get_bundle_mtime(info.bundle_path);
+
+  if (LilvNodes* required_features = lilv_plugin_get_required_features(plugin)) {
+    LILV_FOREACH(nodes, i, required_features) {
+      util::debug(plugin_uri + " requires feature: " + lilv_node_as_uri(lilv_nodes_get(required_features, i)));
+    }
+
+    lilv_nodes_free(required_features);
+  }
+
+  const auto n_ports = lilv_plugin_get_num_ports(plugin);
+
+  info.ports.resize(n_ports);
+
+  // Get the range and the default value of all ports
+
+  std::vector<float> values(n_ports), mins(n_ports), maxs(n_ports);
+
+  lilv_plugin_get_port_ranges_float(plugin, mins.data(), maxs.data(), values.data());
+
+  LilvNode* lv2_InputPort = lilv_new_uri(world, LV2_CORE__InputPort);
+  LilvNode* lv2_OutputPort = lilv_new_uri(world, LV2_CORE__OutputPort);
+  LilvNode* lv2_AudioPort = lilv_new_uri(world, LV2_CORE__AudioPort);
+  LilvNode* lv2_ControlPort = lilv_new_uri(world, LV2_CORE__ControlPort);
+  LilvNode* lv2_AtomPort = lilv_new_uri(world, LV2_ATOM__AtomPort);
+  LilvNode* lv2_connectionOptional = lilv_new_uri(world, LV2_CORE__connectionOptional);
+  LilvNode* lv2_toggled = lilv_new_uri(world, LV2_CORE__toggled);
+  LilvNode* lv2_integer = lilv_new_uri(world, LV2_CORE__integer);
+  LilvNode* lv2_enumeration = lilv_new_uri(world, LV2_CORE__enumeration);
+  LilvNode* lv2_reportsLatency = lilv_new_uri(world, LV2_CORE__reportsLatency);
+  LilvNode* lv2_latency = lilv_new_uri(world, LV2_CORE__latency);
+
+  const auto* latency_port = lilv_plugin_get_port_by_designation(plugin, lv2_OutputPort, lv2_latency);
+
+  for (uint n = 0U; n < n_ports; n++) {
+    auto* port = &info.ports[n];
+
+    const auto* lilv_port = lilv_plugin_get_port_by_index(plugin, n);
+
+    auto* port_name = lilv_port_get_name(plugin, lilv_port);
+
+    port->index = n;
+    port->name = lilv_node_as_string(port_name);
+    port->symbol = lilv_node_as_string(lilv_port_get_symbol(plugin, lilv_port));
+    port->value = std::isnan(values[n]) ? 0.0F : values[n];
+    port->optional = lilv_port_has_property(plugin, lilv_port, lv2_connectionOptional);
+    port->is_input = false;
+    port->min = std::isnan(mins[n]) ? 0.0F : mins[n];
+    port->max = std::isnan(maxs[n]) ? std::max(port->min, port->value) : maxs[n];
+    port->toggled = lilv_port_has_property(plugin, lilv_port, lv2_toggled);
+    port->integer = lilv_port_has_property(plugin, lilv_port, lv2_integer) ||
+                    lilv_port_has_property(plugin, lilv_port, lv2_enumeration);
+    port->reports_latency = lilv_port == latency_port || lilv_port_has_property(plugin, lilv_port, lv2_reportsLatency);
+
+    if (lilv_port_is_a(plugin, lilv_port, lv2_InputPort)) {
+      port->is_input = true;
+    } else if (!lilv_port_is_a(plugin, lilv_port, lv2_OutputPort) && !port->optional) {
+      util::warning("Port " + port->name + " is neither input nor output!");
+    }
+
+    if (lilv_port_is_a(plugin, lilv_port, lv2_ControlPort)) {
+      port->type = TYPE_CONTROL;
+    } else if (lilv_port_is_a(plugin, lilv_port, lv2_AtomPort)) {
+      port->type = TYPE_ATOM;
+    } else if (lilv_port_is_a(plugin, lilv_port, lv2_AudioPort)) {
+      port->type = TYPE_AUDIO;
+
+      info.n_audio_in = (port->is_input) ? info.n_audio_in + 1 : info.n_audio_in;
+      info.n_audio_out = (!port->is_input) ? info.n_audio_out + 1 : info.n_audio_out;
+    } else if (!port->optional) {
+      util::warning("Port " + port->name + " has un unsupported type!");
+    }
+
+    lilv_node_free(port_name);
+  }
+
+  lilv_node_free(lv2_latency);
+  lilv_node_free(lv2_reportsLatency);
+  lilv_node_free(lv2_enumeration);
+  lilv_node_free(lv2_integer);
+  lilv_node_free(lv2_toggled);
+  lilv_node_free(lv2_connectionOptional);
+  lilv_node_free(lv2_ControlPort);
+  lilv_node_free(lv2_AtomPort);
+  lilv_node_free(lv2_AudioPort);
+  lilv_node_free(lv2_OutputPort);
+  lilv_node_free(lv2_InputPort);
+
+  return info;
+}
+
+auto World::get_bundle_mtime(const std::string& bundle_path) -> int64_t {
+  /*
+    Package managers replace the files of a bundle instead of writing over them. So the modification time of the
+    directory changes. The manifest is checked too in case it was edited in place.
+  */
+
+  std::error_code ec;
+
+  const auto dir_time = std::filesystem::last_write_time(bundle_path, ec);
+
+  if (ec) {
+    return -1;
+  }
+
+  auto mtime = static_cast<int64_t>(dir_time.time_since_epoch().count());
+
+  const auto manifest_time = std::filesystem::last_write_time(std::filesystem::path(bundle_path) / "manifest.ttl", ec);
+
+  if (!ec) {
+    mtime = std::max(mtime, static_cast<int64_t>(manifest_time.time_since_epoch().count()));
+  }
+
+  return mtime;
+}
+
+void World::read_cache_file() {
+  if (!std::filesystem::exists(cache_file)) {
+    return;
+  }
+
+  try {
+    std::ifstream is(cache_file);
+
+    const auto json = nlohmann::json::parse(is);
+
+    if (json.value("version", 0) != cache_version) {
+      return;
+    }
+
+    for (const auto& [uri, plugin] : json.at("plugins").items()) {
+      PluginInfo info;
+
+      info.bundle_path = plugin.at("bundle").get<std::string>();
+      info.bundle_mtime = plugin.at("mtime").get<int64_t>();
+      info.n_audio_in = plugin.at("n-audio-in").get<uint>();
+      info.n_audio_out = plugin.at("n-audio-out").get<uint>();
+
+      for (const auto& p : plugin.at("ports")) {
+        info.ports.push_back({.type = static_cast<PortType>(p.at("type").get<int>()),
+                              .index = p.at("index").get<uint>(),
+                              .name = p.at("name").get<std::string>(),
+                              .symbol = p.at("symbol").get<std::string>(),
+                              .value = p.at("default").get<float>(),
+                              .is_input = p.at("input").get<bool>(),
+                              .optional = p.at("optional").get<bool>(),
+                              .min = p.at("min").get<float>(),
+                              .max = p.at("max").get<float>(),
+                              .toggled = p.at("toggled").get<bool>(),
+                              .integer = p.at("integer").get<bool>(),
+                              .reports_latency = p.at("reports-latency").get<bool>()});
+      }
+
+      info_cache.insert_or_assign(uri, std::move(info));
+    }
+
+    util::debug("read the metadata of " + util::to_string(info_cache.size()) + " lv2 plugins from the cache");
+  } catch (const std::exception& e) {
+    util::warning("failed to read the lv2 cache " + cache_file.string() + ": " + e.what());
+
+    info_cache.clear();
+  }
+}
+
+void World::write_cache_file() {
+  nlohmann::json json;
+
+  json["version"] = cache_version;
+
+  json["plugins"] = nlohmann::json::object();
+
+  for (const auto& [uri, info] : info_cache) {
+    auto& plugin = json["plugins"][uri];
+
+    plugin["bundle"] = info.bundle_path;
+    plugin["mtime"] = info.bundle_mtime;
+    plugin["n-audio-in"] = info.n_audio_in;
+    plugin["n-audio-out"] = info.n_audio_out;
+    plugin["ports"] = nlohmann::json::array();
+
+    for (const auto& p : info.ports) {
+      plugin["ports"].push_back({{"type", static_cast<int>(p.type)},
+                                 {"index", p.index},
+                                 {"name", p.name},
+                                 {"symbol", p.symbol},
+                                 {"default", p.value},
+                                 {"input", p.is_input},
+                                 {"optional", p.optional},
+                                 {"min", p.min},
+                                 {"max", p.max},
+                                 {"toggled", p.toggled},
+                                 {"integer", p.integer},
+                                 {"reports-latency", p.reports_latency}});
+    }
+  }
+
+  std::error_code ec;
+
+  std::filesystem::create_directories(cache_file.parent_path(), ec);
+
+  std::ofstream os(cache_file);
+
+  if (!os) {
+    util::warning("failed to write the lv2 cache " + cache_file.string());
+
+    return;
+  }
+
+  os << json.dump();
+}
+
+}  // namespace lv2
@@ -19,6 +19,10 @@
 
 #include "lv2_wrapper.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <ranges>
+
 namespace lv2 {
 
 constexpr auto min_quantum = 32;
@@ -38,152 +42,241 @@ auto lv2_printf(LV2_Log_Handle handle, LV2_URID type, const char* format, ...) -
   return r;
 }
 
-Lv2Wrapper::Lv2Wrapper(const std::string& plugin_uri) : plugin_uri(plugin_uri), world(lilv_world_new()) {
-  if (world == nullptr) {
-    util::warning("failed to initialized the world");
+Lv2Wrapper::Lv2Wrapper(const std::string& plugin_uri) : plugin_uri(plugin_uri) {
+  // The port metadata usually comes from the cache. So we do not have to wait for the world to be loaded.
+
+  const auto* info = World::get().find_plugin_info(plugin_uri);
+
+  if (info == nullptr) {
+    util::warning("Could not find the plugin: " + plugin_uri);
 
     return;
   }
 
-  auto* const uri = lilv_new_uri(world, plugin_uri.c_str());
+  found_plugin = true;
+
+  ports = info->ports;
 
-  if (uri == nullptr) {
-    util::warning("Invalid plugin URI: " + plugin_uri);
+  n_ports = static_cast<uint>(ports.size());
+  n_audio_in = info->n_audio_in;
+  n_audio_out = info->n_audio_out;
 
-    return;
-  }
+  create_port_tables();
 
-  lilv_world_load_all(world);
+  requested_values.resize(n_ports);
+  staged_values.resize(n_ports);
 
-  const LilvPlugins* plugins = lilv_world_get_all_plugins(world);
+  is_pending.resize(n_ports, false);
+  is_staged.resize(n_ports, false);
 
-  plugin = lilv_plugins_get_by_uri(plugins, uri);
+  // reserving the whole capacity now the realtime thread never allocates while applying the changes
 
-  lilv_node_free(uri);
+  pending_changes.reserve(n_ports);
+  staged_changes.reserve(n_ports);
 
-  if (plugin == nullptr) {
-    util::warning("Could not find the plugin: " + plugin_uri);
+  ui_dirty_ports = std::vector<std::atomic<uint64_t>>((n_ports + 63U) / 64U);
 
-    return;
+  for (uint n = 0U; n < n_ports; n++) {
+    requested_values[n] = ports[n].value;
   }
 
-  found_plugin = true;
+  // The instances need the plugin from the world. It is resolved here so that the realtime thread never waits for it.
 
-  check_required_features();
+  World::get().load_async();
 
-  create_ports();
+  if (World::get().is_ready()) {
+    resolve_plugin();
+  } else {
+    world_loaded_connection = World::get().world_loaded.connect([this]() { resolve_plugin(); });
+  }
 }
 
 Lv2Wrapper::~Lv2Wrapper() {
-  if (instance != nullptr) {
-    lilv_instance_deactivate(instance);
-    lilv_instance_free(instance);
+  world_loaded_connection.disconnect();
 
-    instance = nullptr;
+  {
+    std::scoped_lock<std::mutex> lock(changes_mutex);
+
+    if (commit_source_id != 0U) {
+      g_source_remove(commit_source_id);
+    }
   }
 
-  if (world != nullptr) {
-    lilv_world_free(world);
+  {
+    std::scoped_lock<std::mutex> lock(instance_mutex);
+
+    if (instance_source_id != 0U) {
+      g_source_remove(instance_source_id);
+    }
   }
-}
 
-void Lv2Wrapper::check_required_features() {
-  LilvNodes* required_features = lilv_plugin_get_required_features(plugin);
+  // The filter is not running anymore. So every instance can be freed from here.
 
-  if (required_features != nullptr) {
-    for (auto* i = lilv_nodes_begin(required_features); !lilv_nodes_is_end(required_features, i);
-         i = lilv_nodes_next(required_features, i)) {
-      const LilvNode* required_feature = lilv_nodes_get(required_features, i);
+  worker.stop();
 
-      const char* required_feature_uri = lilv_node_as_uri(required_feature);
+  std::scoped_lock<std::mutex> lock(World::get().mutex);
 
-      util::debug(plugin_uri + " requires feature: " + required_feature_uri);
+  for (auto* active_instance : {instance, prepared_instance.exchange(nullptr), retired_instance.exchange(nullptr)}) {
+    if (active_instance != nullptr) {
+      lilv_instance_deactivate(active_instance);
+      lilv_instance_free(active_instance);
     }
+  }
+
+  instance = nullptr;
 
-    lilv_nodes_free(required_features);
+  for (auto* idle_instance : idle_instances | std::views::values) {
+    lilv_instance_free(idle_instance);
   }
 }
 
-void Lv2Wrapper::create_ports() {
-  n_ports = lilv_plugin_get_num_ports(plugin);
+void Lv2Wrapper::resolve_plugin() {
+  const auto* lilv_plugin = World::get().find_plugin(plugin_uri);
 
-  ports.resize(n_ports);
+  if (lilv_plugin == nullptr) {
+    util::warning("Could not find the plugin: " + plugin_uri);
+  }
 
-  // Get default values for all ports
+  plugin.store(lilv_plugin, std::memory_order_release);
 
-  std::vector<float> values(n_ports);
+  // the realtime thread may have asked for an instance before the world was loaded
 
-  lilv_plugin_get_port_ranges_float(plugin, nullptr, nullptr, values.data());
+  update_instance();
+}
 
-  LilvNode* lv2_InputPort = lilv_new_uri(world, LV2_CORE__InputPort);
-  LilvNode* lv2_OutputPort = lilv_new_uri(world, LV2_CORE__OutputPort);
-  LilvNode* lv2_AudioPort = lilv_new_uri(world, LV2_CORE__AudioPort);
-  LilvNode* lv2_ControlPort = lilv_new_uri(world, LV2_CORE__ControlPort);
-  LilvNode* lv2_AtomPort = lilv_new_uri(world, LV2_ATOM__AtomPort);
-  LilvNode* lv2_connectionOptional = lilv_new_uri(world, LV2_CORE__connectionOptional);
+void Lv2Wrapper::create_instance(const uint& rate) {
+  this->rate = rate;
 
-  for (uint n = 0U; n < n_ports; n++) {
-    auto* port = &ports[n];
+  if (instance != nullptr) {
+    retire_instance(instance, instance_rate);
 
-    const auto* lilv_port = lilv_plugin_get_port_by_index(plugin, n);
+    instance = nullptr;
+  }
+
+  requested_rate.store(rate, std::memory_order_relaxed);
 
-    auto* port_name = lilv_port_get_name(plugin, lilv_port);
+  schedule_instance_update();
+}
+
+void Lv2Wrapper::prepare_instance(const uint& rate) {
+  this->rate = rate;
 
-    port->index = n;
-    port->name = lilv_node_as_string(port_name);
-    port->symbol = lilv_node_as_string(lilv_port_get_symbol(plugin, lilv_port));
-    port->value = std::isnan(values[n]) ? 0.0F : values[n];
-    port->optional = lilv_port_has_property(plugin, lilv_port, lv2_connectionOptional);
+  requested_rate.store(rate, std::memory_order_relaxed);
 
-    // util::warning("port name: " + port->name);
-    // util::warning("port symbol: " + port->symbol);
+  update_instance();
+}
+
+void Lv2Wrapper::retire_instance(LilvInstance* old_instance, const uint& old_rate) {
+  retired_rate.store(old_rate, std::memory_order_relaxed);
+
+  retired_instance.store(old_instance, std::memory_order_release);
+}
 
-    if (lilv_port_is_a(plugin, lilv_port, lv2_InputPort)) {
-      port->is_input = true;
-    } else if (!lilv_port_is_a(plugin, lilv_port, lv2_OutputPort) && !port->optional) {
-      util::warning("Port " + port->name + " is neither input nor output!");
+void Lv2Wrapper::schedule_instance_update() {
+  std::scoped_lock<std::mutex> lock(instance_mutex);
+
+  if (instance_source_id != 0U) {
+    return;
+  }
+
+  instance_source_id = g_idle_add_full(
+      G_PRIORITY_HIGH,
+      +[](gpointer user_data) {
+        auto* self = static_cast<Lv2Wrapper*>(user_data);
+
+        {
+          std::scoped_lock<std::mutex> lock(self->instance_mutex);
+
+          self->instance_source_id = 0U;
+        }
+
+        self->update_instance();
+
+        return G_SOURCE_REMOVE;
+      },
+      this, nullptr);
+}
+
+void Lv2Wrapper::update_instance() {
+  if (auto* old_instance = retired_instance.exchange(nullptr, std::memory_order_acquire); old_instance != nullptr) {
+    park_instance(old_instance, retired_rate.load(std::memory_order_relaxed));
+
+    instance_published = false;
+  }
+
+  const auto rate = requested_rate.load(std::memory_order_relaxed);
+
+  // an instance the realtime thread did not take before the rate changed again
+
+  if (prepared_rate.load(std::memory_order_relaxed) != rate) {
+    if (auto* old_instance = prepared_instance.exchange(nullptr, std::memory_order_acquire); old_instance != nullptr) {
+      park_instance(old_instance, prepared_rate.load(std::memory_order_relaxed));
+
+      instance_published = false;
     }
+  }
 
-    if (lilv_port_is_a(plugin, lilv_port, lv2_ControlPort)) {
-      port->type = TYPE_CONTROL;
-    } else if (lilv_port_is_a(plugin, lilv_port, lv2_AtomPort)) {
-      port->type = TYPE_ATOM;
+  const auto* lilv_plugin = plugin.load(std::memory_order_acquire);
 
-      // util::warning("port name: " + port->name);
-    } else if (lilv_port_is_a(plugin, lilv_port, lv2_AudioPort)) {
-      port->type = TYPE_AUDIO;
+  if (instance_published || rate == 0U || lilv_plugin == nullptr) {
+    return;
+  }
+
+  LilvInstance* new_instance = nullptr;
+
+  {
+    std::scoped_lock<std::mutex> lock(World::get().mutex);
+
+    if (const auto it = std::ranges::find(idle_instances, rate, &std::pair<uint, LilvInstance*>::first);
+        it != idle_instances.end()) {
+      util::debug(plugin_uri + " reusing the instance created for the rate " + util::to_string(rate));
 
-      n_audio_in = (port->is_input) ? n_audio_in + 1 : n_audio_in;
-      n_audio_out = (!port->is_input) ? n_audio_out + 1 : n_audio_out;
-    } else if (!port->optional) {
-      util::warning("Port " + port->name + " has un unsupported type!");
+      new_instance = it->second;
+
+      idle_instances.erase(it);
+    } else {
+      new_instance = instantiate(lilv_plugin, rate);
     }
+  }
 
-    lilv_node_free(port_name);
+  if (new_instance == nullptr) {
+    return;
   }
 
-  // util::warning("n audio_in ports: " + util::to_string(n_audio_in));
-  // util::warning("n audio_out ports: " + util::to_string(n_audio_out));
+  connect_control_ports(new_instance);
+
+  restore_state(new_instance);
 
-  lilv_node_free(lv2_connectionOptional);
-  lilv_node_free(lv2_ControlPort);
-  lilv_node_free(lv2_AtomPort);
-  lilv_node_free(lv2_AudioPort);
-  lilv_node_free(lv2_OutputPort);
-  lilv_node_free(lv2_InputPort);
+  worker.start(new_instance);
+
+  lilv_instance_activate(new_instance);
+
+  prepared_rate.store(rate, std::memory_order_relaxed);
+
+  prepared_instance.store(new_instance, std::memory_order_release);
+
+  instance_published = true;
 }
 
-auto Lv2Wrapper::create_instance(const uint& rate) -> bool {
-  this->rate = rate;
+void Lv2Wrapper::park_instance(LilvInstance* old_instance, const uint& old_rate) {
+  // The realtime thread does not run it anymore. The worker always belongs to the instance in flight.
 
-  if (instance != nullptr) {
-    deactivate();
+  worker.stop();
 
-    lilv_instance_free(instance);
+  lilv_instance_deactivate(old_instance);
 
-    instance = nullptr;
+  std::scoped_lock<std::mutex> lock(World::get().mutex);
+
+  idle_instances.emplace_back(old_rate, old_instance);
+
+  if (idle_instances.size() > max_idle_instances) {
+    lilv_instance_free(idle_instances.front().second);
+
+    idle_instances.erase(idle_instances.begin());
   }
+}
 
+auto Lv2Wrapper::instantiate(const LilvPlugin* lilv_plugin, const uint& rate) -> LilvInstance* {
   LV2_Log_Log lv2_log = {this, &lv2_printf, [](LV2_Log_Handle handle, LV2_URID type, const char* fmt, va_list ap) {
                            return std::vprintf(fmt, ap);
                          }};
@@ -206,6 +299,8 @@ auto Lv2Wrapper::create_instance(const uint& rate) -> bool {
 
   const LV2_Feature lv2_unmap_feature = {LV2_URID__unmap, &lv2_unmap};
 
+  const LV2_Feature worker_schedule_feature = {LV2_WORKER__schedule, &worker.schedule_data};
+
   auto options = std::to_array<LV2_Options_Option>(
       {{LV2_OPTIONS_INSTANCE, 0, map_urid(LV2_PARAMETERS__sampleRate), sizeof(float), map_urid(LV2_ATOM__Float), &rate},
        {LV2_OPTIONS_INSTANCE, 0, map_urid(LV2_BUF_SIZE__minBlockLength), sizeof(int32_t), map_urid(LV2_ATOM__Int),
@@ -218,30 +313,55 @@ auto Lv2Wrapper::create_instance(const uint& rate) -> bool {
 
   LV2_Feature feature_options = {.URI = LV2_OPTIONS__options, .data = options.data()};
 
-  const auto features = std::to_array<const LV2_Feature*>(
-      {&lv2_log_feature, &lv2_map_feature, &lv2_unmap_feature, &feature_options, static_features.data(), nullptr});
+  const auto features =
+      std::to_array<const LV2_Feature*>({&lv2_log_feature, &lv2_map_feature, &lv2_unmap_feature, &feature_options,
+                                         &worker_schedule_feature, static_features.data(), nullptr});
 
-  instance = lilv_plugin_instantiate(plugin, rate, features.data());
+  auto* new_instance = lilv_plugin_instantiate(lilv_plugin, rate, features.data());
 
-  if (instance == nullptr) {
+  if (new_instance == nullptr) {
     util::warning("failed to instantiate " + plugin_uri);
+  }
 
-    return false;
+  return new_instance;
+}
+
+void Lv2Wrapper::connect_control_ports(LilvInstance* target) {
+  for (auto& p : ports) {
+    if (p.type == PortType::TYPE_CONTROL) {
+      lilv_instance_connect_port(target, p.index, &p.value);
+    }
   }
+}
 
-  connect_control_ports();
+void Lv2Wrapper::create_port_tables() {
+  // Everything the realtime thread needs to know about the ports is resolved here only once
 
-  activate();
+  uint count_input = 0U;
+  uint count_output = 0U;
 
-  return true;
-}
+  for (uint n = 0U; n < ports.size(); n++) {
+    const auto& p = ports[n];
 
-void Lv2Wrapper::connect_control_ports() {
-  for (auto& p : ports) {
     if (p.type == PortType::TYPE_CONTROL) {
-      lilv_instance_connect_port(instance, p.index, &p.value);
+      control_ports[p.symbol] = n;
+
+      if (!p.is_input) {
+        output_control_ports.push_back(n);
+
+        ui_output_values.push_back(p.value);
+      }
+    } else if (p.type == PortType::TYPE_AUDIO) {
+      if (p.is_input && count_input < audio_in_ports.size()) {
+        audio_in_ports[count_input++] = p.index;
+      } else if (!p.is_input && count_output < audio_out_ports.size()) {
+        audio_out_ports[count_output++] = p.index;
+      }
     }
   }
+
+  n_audio_in = std::min(n_audio_in, static_cast<uint>(audio_in_ports.size()));
+  n_audio_out = std::min(n_audio_out, static_cast<uint>(audio_out_ports.size()));
 }
 
 void Lv2Wrapper::connect_data_ports(std::span<float>& left_in,
@@ -252,29 +372,15 @@ void Lv2Wrapper::connect_data_ports(std::span<float>& left_in,
     return;
   }
 
-  int count_input = 0;
-  int count_output = 0;
+  const auto inputs = std::to_array<float*>({left_in.data(), right_in.data()});
+  const auto outputs = std::to_array<float*>({left_out.data(), right_out.data()});
 
-  for (const auto& p : ports) {
-    if (p.type == PortType::TYPE_AUDIO) {
-      if (p.is_input) {
-        if (count_input == 0) {
-          lilv_instance_connect_port(instance, p.index, left_in.data());
-        } else if (count_input == 1) {
-          lilv_instance_connect_port(instance, p.index, right_in.data());
-        }
-
-        count_input++;
-      } else {
-        if (count_output == 0) {
-          lilv_instance_connect_port(instance, p.index, left_out.data());
-        } else if (count_output == 1) {
-          lilv_instance_connect_port(instance, p.index, right_out.data());
-        }
+  for (uint n = 0U; n < std::min(n_audio_in, 2U); n++) {
+    lilv_instance_connect_port(instance, audio_in_ports[n], inputs[n]);
+  }
 
-        count_output++;
-      }
-    }
+  for (uint n = 0U; n < n_audio_out; n++) {
+    lilv_instance_connect_port(instance, audio_out_ports[n], outputs[n]);
   }
 }
 
@@ -288,33 +394,15 @@ void Lv2Wrapper::connect_data_ports(std::span<float>& left_in,
     return;
   }
 
-  int count_input = 0;
-  int count_output = 0;
-
-  for (const auto& p : ports) {
-    if (p.type == PortType::TYPE_AUDIO) {
-      if (p.is_input) {
-        if (count_input == 0) {
-          lilv_instance_connect_port(instance, p.index, left_in.data());
-        } else if (count_input == 1) {
-          lilv_instance_connect_port(instance, p.index, right_in.data());
-        } else if (count_input == 2) {
-          lilv_instance_connect_port(instance, p.index, probe_left.data());
-        } else if (count_input == 3) {
-          lilv_instance_connect_port(instance, p.index, probe_right.data());
-        }
+  const auto inputs = std::to_array<float*>({left_in.data(), right_in.data(), probe_left.data(), probe_right.data()});
+  const auto outputs = std::to_array<float*>({left_out.data(), right_out.data()});
 
-        count_input++;
-      } else {
-        if (count_output == 0) {
-          lilv_instance_connect_port(instance, p.index, left_out.data());
-        } else if (count_output == 1) {
-          lilv_instance_connect_port(instance, p.index, right_out.data());
-        }
+  for (uint n = 0U; n < n_audio_in; n++) {
+    lilv_instance_connect_port(instance, audio_in_ports[n], inputs[n]);
+  }
 
-        count_output++;
-      }
-    }
+  for (uint n = 0U; n < n_audio_out; n++) {
+    lilv_instance_connect_port(instance, audio_out_ports[n], outputs[n]);
   }
 }
 
@@ -334,54 +422,268 @@ void Lv2Wrapper::activate() {
   lilv_instance_activate(instance);
 }
 
-void Lv2Wrapper::run() const {
-  if (instance != nullptr) {
-    lilv_instance_run(instance, n_samples);
+void Lv2Wrapper::run() {
+  if (instance == nullptr) {
+    return;
+  }
+
+  apply_staged_changes();
+
+  lilv_instance_run(instance, n_samples);
+
+  worker.deliver_responses();
+
+  if (ui_active.load(std::memory_order_relaxed)) {
+    mark_changed_outputs();
+  }
+}
+
+void Lv2Wrapper::mark_changed_outputs() {
+  for (uint n = 0U; n < output_control_ports.size(); n++) {
+    const auto& value = ports[output_control_ports[n]].value;
+
+    if (value != ui_output_values[n]) {
+      ui_output_values[n] = value;
+
+      mark_ui_dirty(output_control_ports[n]);
+    }
   }
 }
 
+void Lv2Wrapper::mark_ui_dirty(const uint& port) {
+  ui_dirty_ports[port / 64U].fetch_or(uint64_t{1} << (port % 64U), std::memory_order_release);
+}
+
+void Lv2Wrapper::apply_staged_changes() {
+  // If a commit is being published right now its changes are applied in the next block
+
+  if (staging_lock.test_and_set(std::memory_order_acquire)) {
+    return;
+  }
+
+  for (const auto& n : staged_changes) {
+    ports[n].value = staged_values[n];
+
+    is_staged[n] = false;
+  }
+
+  staged_changes.clear();
+
+  staging_lock.clear(std::memory_order_release);
+}
+
 void Lv2Wrapper::deactivate() {
   lilv_instance_deactivate(instance);
 }
 
 void Lv2Wrapper::set_control_port_value(const std::string& symbol, const float& value) {
-  auto found = false;
+  const auto it = control_ports.find(symbol);
 
-  for (auto& p : ports) {
-    if (p.type == PortType::TYPE_CONTROL && p.symbol == symbol) {
-      if (!p.is_input) {
-        util::warning(plugin_uri + " port " + symbol + " is not an input!");
+  if (it == control_ports.end()) {
+    util::warning(plugin_uri + " port symbol not found: " + symbol);
 
-        return;
-      }
+    return;
+  }
 
-      ui_port_event(p.index, value);
+  auto& p = ports[it->second];
 
-      p.value = value;
+  if (!p.is_input) {
+    util::warning(plugin_uri + " port " + symbol + " is not an input!");
 
-      found = true;
+    return;
+  }
+
+  request_control_port_value(it->second, value);
+}
 
-      break;
+void Lv2Wrapper::set_control_port_values(std::span<const PortValue> values) {
+  std::scoped_lock<std::mutex> lock(changes_mutex);
+
+  for (const auto& v : values) {
+    if (v.port.index < 0 || !ports[v.port.index].is_input) {
+      continue;
     }
+
+    stage_control_port_value(static_cast<uint>(v.port.index), v.value, false);
   }
 
-  if (!found) {
-    util::warning(plugin_uri + " port symbol not found: " + symbol);
+  schedule_commit();
+}
+
+void Lv2Wrapper::request_control_port_value(const uint& port, const float& value, const bool& from_ui) {
+  std::scoped_lock<std::mutex> lock(changes_mutex);
+
+  stage_control_port_value(port, value, from_ui);
+
+  schedule_commit();
+}
+
+void Lv2Wrapper::stage_control_port_value(const uint& port, const float& value, const bool& from_ui) {
+  requested_values[port] = value;
+
+  // there is no need to echo back to the native ui the values it has just written
+
+  if (!from_ui && ui_active.load(std::memory_order_relaxed)) {
+    mark_ui_dirty(port);
+  }
+
+  if (!is_pending[port]) {
+    is_pending[port] = true;
+
+    pending_changes.push_back(port);
+  }
+}
+
+void Lv2Wrapper::schedule_commit() {
+  if (commit_source_id != 0U) {
+    return;
+  }
+
+  commit_source_id = g_idle_add_full(
+      G_PRIORITY_HIGH,
+      +[](gpointer user_data) {
+        auto* self = static_cast<Lv2Wrapper*>(user_data);
+
+        {
+          std::scoped_lock<std::mutex> lock(self->changes_mutex);
+
+          self->commit_source_id = 0U;
+        }
+
+        self->commit_control_port_values();
+
+        return G_SOURCE_REMOVE;
+      },
+      this, nullptr);
+}
+
+void Lv2Wrapper::commit_control_port_values() {
+  std::scoped_lock<std::mutex> lock(changes_mutex);
+
+  if (pending_changes.empty()) {
+    return;
+  }
+
+  // The realtime thread holds the lock only while copying a few floats
+
+  while (staging_lock.test_and_set(std::memory_order_acquire)) {
+    std::this_thread::yield();
   }
+
+  for (const auto& n : pending_changes) {
+    staged_values[n] = requested_values[n];
+
+    if (!is_staged[n]) {
+      is_staged[n] = true;
+
+      staged_changes.push_back(n);
+    }
+
+    is_pending[n] = false;
+  }
+
+  staging_lock.clear(std::memory_order_release);
+
+  pending_changes.clear();
 }
+
 auto Lv2Wrapper::get_control_port_value(const std::string& symbol) -> float {
-  for (const auto& p : ports) {
-    if (p.type == PortType::TYPE_CONTROL && p.symbol == symbol) {
-      return p.value;
+  const auto it = control_ports.find(symbol);
+
+  if (it == control_ports.end()) {
+    util::warning(plugin_uri + " port symbol not found: " + symbol);
+
+    return 0.0F;
+  }
+
+  const auto& n = it->second;
+
+  if (ports[n].is_input) {
+    std::scoped_lock<std::mutex> lock(changes_mutex);
+
+    return requested_values[n];
+  }
+
+  return ports[n].value;
+}
+
+auto Lv2Wrapper::find_control_port(const std::string& symbol) const -> ControlPort {
+  const auto it = control_ports.find(symbol);
+
+  if (it == control_ports.end()) {
+    if (found_plugin) {
+      util::warning(plugin_uri + " port symbol not found: " + symbol);
     }
+
+    return {};
   }
 
-  util::warning(plugin_uri + " port symbol not found: " + symbol);
+  return {.index = static_cast<int>(it->second)};
+}
+
+void Lv2Wrapper::bind_key(GSettings* settings,
+                          const std::string& symbol,
+                          const char* gkey,
+                          float (*read_key)(GSettings* settings, const char* key)) {
+  const auto port = find_control_port(symbol);
+
+  const auto value = std::to_array<PortValue>({{.port = port, .value = read_key(settings, gkey)}});
+
+  set_control_port_values(value);
+
+  if (!gsettings_bindings.contains(settings)) {
+    g_signal_connect(settings, "change-event",
+                     G_CALLBACK(+[](GSettings* settings, GQuark* keys, gint n_keys, gpointer user_data) {
+                       auto* self = static_cast<Lv2Wrapper*>(user_data);
+
+                       self->on_settings_change_event(settings, std::span<const GQuark>(keys, n_keys));
 
-  return 0.0F;
+                       return 0;  // the changed signals still have to be emitted
+                     }),
+                     this);
+  }
+
+  gsettings_bindings[settings][g_quark_from_string(gkey)] = {.port = port, .read_key = read_key};
+}
+
+void Lv2Wrapper::on_settings_change_event(GSettings* settings, std::span<const GQuark> keys) {
+  const auto& bindings = gsettings_bindings[settings];
+
+  std::vector<PortValue> values;
+
+  if (keys.empty()) {
+    // every key may have changed
+
+    for (const auto& [quark, binding] : bindings) {
+      values.push_back({.port = binding.port, .value = binding.read_key(settings, g_quark_to_string(quark))});
+    }
+  } else {
+    for (const auto& quark : keys) {
+      if (const auto it = bindings.find(quark); it != bindings.end()) {
+        values.push_back({.port = it->second.port, .value = it->second.read_key(settings, g_quark_to_string(quark))});
+      }
+    }
+  }
+
+  set_control_port_values(values);
 }
 
 auto Lv2Wrapper::has_instance() -> bool {
+  if (instance == nullptr && prepared_instance.load(std::memory_order_relaxed) != nullptr) {
+    if (auto* new_instance = prepared_instance.exchange(nullptr, std::memory_order_acquire); new_instance != nullptr) {
+      const auto new_rate = prepared_rate.load(std::memory_order_relaxed);
+
+      if (new_rate == rate) {
+        instance = new_instance;
+        instance_rate = new_rate;
+      } else {
+        retire_instance(new_instance, new_rate);
+
+        schedule_instance_update();
+      }
+    }
+  }
+
   return instance != nullptr;
 }
 
@@ -404,13 +706,15 @@ void Lv2Wrapper::load_ui() {
 
   std::thread ui_updater([=, this]() {
     {
-      std::scoped_lock<std::mutex> lku(ui_mutex);
+      std::scoped_lock lku(ui_mutex, World::get().mutex);
+
+      const auto* lilv_plugin = plugin.load();
 
-      if (instance == nullptr) {
+      if (instance == nullptr || lilv_plugin == nullptr) {
         return;
       }
 
-      LilvUIs* uis = lilv_plugin_get_uis(plugin);
+      LilvUIs* uis = lilv_plugin_get_uis(lilv_plugin);
 
       if (uis == nullptr) {
         return;
@@ -539,13 +843,11 @@ void Lv2Wrapper::load_ui() {
                   const void* buffer) {
                 auto self = static_cast<Lv2Wrapper*>(controller);
 
-                for (auto& p : self->ports) {
-                  if (p.index == port_index) {
-                    // util::warning("The user clicked on port: " + p.name + " -> " + p.symbol);
+                // the ports table is ordered by the port index
 
-                    if (port_protocol == 0) {  // port is a ui:floatProtocol
-                      p.value = *static_cast<const float*>(buffer);
-                    }
+                if (port_index < self->ports.size() && port_protocol == 0) {  // port is a ui:floatProtocol
+                  if (const auto& p = self->ports[port_index]; p.type == PortType::TYPE_CONTROL && p.is_input) {
+                    self->request_control_port_value(port_index, *static_cast<const float*>(buffer), true);
                   }
                 }
               },
@@ -572,14 +874,31 @@ void Lv2Wrapper::load_ui() {
       lilv_uis_free(uis);
     }
 
-    // initilizing the ui with the current control values
+    if (!has_ui()) {
+      return;
+    }
+
+    // initilizing the ui with the current control values. After that only the ports that changed are sent.
 
     for (const auto& p : ports) {
       if (p.type == PortType::TYPE_CONTROL) {
-        ui_descriptor->port_event(ui_handle, p.index, sizeof(float), 0, &p.value);
+        const auto value = get_control_port_value(p.symbol);
+
+        ui_descriptor->port_event(ui_handle, p.index, sizeof(float), 0, &value);
       }
     }
 
+    for (auto& word : ui_dirty_ports) {
+      word.store(0U, std::memory_order_relaxed);
+    }
+
+    ui_active.store(true, std::memory_order_relaxed);
+
+    /*
+      The native ui toolkit still needs its idle callback to handle its own window events. But the port values are
+      only forwarded when the plugin or the user changed them.
+    */
+
     while (has_ui()) {
       {
         std::scoped_lock<std::mutex> lk(ui_mutex);
@@ -604,9 +923,19 @@ void Lv2Wrapper::notify_ui() {
     return;
   }
 
-  for (const auto& p : ports) {
-    if (p.type == PortType::TYPE_CONTROL && !p.is_input) {
-      ui_descriptor->port_event(ui_handle, p.index, sizeof(float), 0, &p.value);
+  for (uint w = 0U; w < ui_dirty_ports.size(); w++) {
+    auto bits = ui_dirty_ports[w].exchange(0U, std::memory_order_acquire);
+
+    while (bits != 0U) {
+      const auto n = w * 64U + static_cast<uint>(std::countr_zero(bits));
+
+      bits &= bits - 1U;
+
+      const auto& p = ports[n];
+
+      const auto value = (p.is_input) ? get_control_port_value(p.symbol) : p.value;
+
+      ui_descriptor->port_event(ui_handle, p.index, sizeof(float), 0, &value);
     }
   }
 }
@@ -626,6 +955,8 @@ auto Lv2Wrapper::has_ui() -> bool {
 void Lv2Wrapper::close_ui() {
   std::scoped_lock<std::mutex> lk(ui_mutex);
 
+  ui_active.store(false, std::memory_order_relaxed);
+
   if (ui_descriptor != nullptr && ui_handle != nullptr) {
     ui_descriptor->cleanup(ui_handle);
   }
@@ -643,14 +974,6 @@ void Lv2Wrapper::set_ui_update_rate(const uint& value) {
   ui_update_rate = value;
 }
 
-void Lv2Wrapper::ui_port_event(const uint& port_index, const float& value) {
-  if (ui_descriptor == nullptr || ui_handle == nullptr) {
-    return;
-  }
-
-  ui_descriptor->port_event(ui_handle, port_index, sizeof(float), 0, &value);
-}
-
 void Lv2Wrapper::native_ui_to_gsettings() {
   if (ui_descriptor == nullptr || ui_handle == nullptr) {  // only write to the database if the native ui is being used
     return;
@@ -661,4 +984,117 @@ void Lv2Wrapper::native_ui_to_gsettings() {
   }
 }
 
+auto Lv2Wrapper::has_state_interface() const -> bool {
+  return instance != nullptr && lilv_instance_get_extension_data(instance, LV2_STATE__interface) != nullptr;
+}
+
+auto Lv2Wrapper::save_state() -> std::vector<StateProperty> {
+  std::vector<StateProperty> properties;
+
+  if (!has_state_interface()) {
+    return properties;
+  }
+
+  const auto* iface =
+      static_cast<const LV2_State_Interface*>(lilv_instance_get_extension_data(instance, LV2_STATE__interface));
+
+  if (iface->save == nullptr) {
+    return properties;
+  }
+
+  auto store = [](LV2_State_Handle handle, uint32_t key, const void* value, size_t size, uint32_t type,
+                  uint32_t flags) {
+    auto* self = static_cast<Lv2Wrapper*>(handle);
+
+    // without the map path feature only plain old data can be saved
+
+    if ((flags & LV2_STATE_IS_POD) == 0U) {
+      return LV2_STATE_ERR_UNKNOWN;
+    }
+
+    const auto* data = static_cast<const uint8_t*>(value);
+
+    self->saved_state.push_back({.key = self->map_urid_to_uri[key],
+                                 .type = self->map_urid_to_uri[type],
+                                 .flags = flags,
+                                 .value = std::vector<uint8_t>(data, data + size)});
+
+    return LV2_STATE_SUCCESS;
+  };
+
+  saved_state.clear();
+
+  const auto status =
+      iface->save(lilv_instance_get_handle(instance), store, this, LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE, nullptr);
+
+  if (status != LV2_STATE_SUCCESS) {
+    util::warning(plugin_uri + " failed to save its state");
+  }
+
+  properties.swap(saved_state);
+
+  return properties;
+}
+
+void Lv2Wrapper::set_state(std::vector<StateProperty> properties) {
+  state = std::move(properties);
+}
+
+auto Lv2Wrapper::get_state() const -> const std::vector<StateProperty>& {
+  return state;
+}
+
+auto Lv2Wrapper::restore_state(LilvInstance* target) -> bool {
+  if (state.empty()) {
+    return true;
+  }
+
+  const auto* iface =
+      static_cast<const LV2_State_Interface*>(lilv_instance_get_extension_data(target, LV2_STATE__interface));
+
+  if (iface == nullptr || iface->restore == nullptr) {
+    return false;
+  }
+
+  // the urids of the saved keys and types
+
+  std::unordered_map<LV2_URID, const StateProperty*> restored;
+
+  for (const auto& p : state) {
+    restored[map_urid(p.key)] = &p;
+  }
+
+  auto retrieve = [](LV2_State_Handle handle, uint32_t key, size_t* size, uint32_t* type, uint32_t* flags) {
+    auto* self = static_cast<Lv2Wrapper*>(handle);
+
+    const auto it = self->restored_state->find(key);
+
+    if (it == self->restored_state->end()) {
+      return static_cast<const void*>(nullptr);
+    }
+
+    const auto& p = *it->second;
+
+    *size = p.value.size();
+    *type = self->map_urid(p.type);
+    *flags = p.flags;
+
+    return static_cast<const void*>(p.value.data());
+  };
+
+  restored_state = &restored;
+
+  const auto status = iface->restore(lilv_instance_get_handle(target), retrieve, this, 0U, nullptr);
+
+  restored_state = nullptr;
+
+  if (status != LV2_STATE_SUCCESS) {
+    util::warning(plugin_uri + " failed to restore its state");
+
+    return false;
+  }
+
+  return true;
+}
+
 }  // namespace lv2
@@ -38,6 +38,9 @@ Maximizer::Maximizer(const std::string& tag,
 
   lv2_wrapper->bind_key_double<"rel", "release">(settings);
 
+  latency_port = lv2_wrapper->find_control_port("lv2_latency");
+  reduction_port = lv2_wrapper->find_control_port("gr");
+
   setup_input_output_gain();
 
   // g_timeout_add_seconds(1, GSourceFunc(+[](Maximizer* self) {
@@ -100,7 +103,7 @@ void Maximizer::process(std::span<float>& left_in,
     This plugin gives the latency in number of samples
   */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("lv2_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -126,7 +129,7 @@ void Maximizer::process(std::span<float>& left_in,
     if (send_notifications) {
       // reduction needed as double for levelbar widget ui, so we convert it here
 
-      reduction_port_value = static_cast<double>(lv2_wrapper->get_control_port_value("gr"));
+      reduction_port_value = static_cast<double>(lv2_wrapper->get_control_port_value(reduction_port));
 
       reduction.emit(reduction_port_value);
 
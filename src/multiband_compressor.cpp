@@ -57,6 +57,17 @@ MultibandCompressor::MultibandCompressor(const std::string& tag,
 
   bind_bands(std::make_index_sequence<n_bands>());
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+
+  for (uint n = 0U; n < n_bands; n++) {
+    const auto nstr = util::to_string(n);
+
+    frequency_range_end_ports.at(n) = lv2_wrapper->find_control_port("fre_" + nstr);
+    envelope_ports.at(n) = lv2_wrapper->find_control_port("elm_" + nstr);
+    curve_ports.at(n) = lv2_wrapper->find_control_port("clm_" + nstr);
+    reduction_ports.at(n) = lv2_wrapper->find_control_port("rlm_" + nstr);
+  }
+
   setup_input_output_gain();
 }
 
@@ -108,7 +119,7 @@ void MultibandCompressor::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -133,12 +144,10 @@ void MultibandCompressor::process(std::span<float>& left_in,
 
     if (send_notifications) {
       for (uint n = 0U; n < n_bands; n++) {
-        const auto nstr = util::to_string(n);
-
-        frequency_range_end_port_array.at(n) = lv2_wrapper->get_control_port_value("fre_" + nstr);
-        envelope_port_array.at(n) = lv2_wrapper->get_control_port_value("elm_" + nstr);
-        curve_port_array.at(n) = lv2_wrapper->get_control_port_value("clm_" + nstr);
-        reduction_port_array.at(n) = lv2_wrapper->get_control_port_value("rlm_" + nstr);
+        frequency_range_end_port_array.at(n) = lv2_wrapper->get_control_port_value(frequency_range_end_ports.at(n));
+        envelope_port_array.at(n) = lv2_wrapper->get_control_port_value(envelope_ports.at(n));
+        curve_port_array.at(n) = lv2_wrapper->get_control_port_value(curve_ports.at(n));
+        reduction_port_array.at(n) = lv2_wrapper->get_control_port_value(reduction_ports.at(n));
       }
 
       frequency_range.emit(frequency_range_end_port_array);
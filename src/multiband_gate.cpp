@@ -57,6 +57,18 @@ MultibandGate::MultibandGate(const std::string& tag,
 
   bind_bands(std::make_index_sequence<n_bands>());
 
+  latency_port = lv2_wrapper->find_control_port("out_latency");
+
+  for (uint n = 0U; n < n_bands; n++) {
+    const auto nstr = util::to_string(n);
+
+    frequency_range_end_ports.at(n) = lv2_wrapper->find_control_port("fre_" + nstr);
+    envelope_ports.at(n) = lv2_wrapper->find_control_port("elm_" + nstr);
+    curve_ports.at(n) = lv2_wrapper->find_control_port("clm_" + nstr);
+    reduction_ports.at(n) = lv2_wrapper->find_control_port("rlm_" + nstr);
+    max_reduction_ports.at(n) = lv2_wrapper->find_control_port("gr_" + nstr);
+  }
+
   setup_input_output_gain();
 }
 
@@ -108,7 +120,7 @@ void MultibandGate::process(std::span<float>& left_in,
    This plugin gives the latency in number of samples
  */
 
-  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value("out_latency"));
+  const auto lv = static_cast<uint>(lv2_wrapper->get_control_port_value(latency_port));
 
   if (latency_n_frames != lv) {
     latency_n_frames = lv;
@@ -133,18 +145,16 @@ void MultibandGate::process(std::span<float>& left_in,
 
     if (send_notifications) {
       for (uint n = 0U; n < n_bands; n++) {
-        const auto nstr = util::to_string(n);
-
-        frequency_range_end_port_array.at(n) = lv2_wrapper->get_control_port_value("fre_" + nstr);
-        envelope_port_array.at(n) = lv2_wrapper->get_control_port_value("elm_" + nstr);
-        curve_port_array.at(n) = lv2_wrapper->get_control_port_value("clm_" + nstr);
-        reduction_port_array.at(n) = lv2_wrapper->get_control_port_value("rlm_" + nstr);
+        frequency_range_end_port_array.at(n) = lv2_wrapper->get_control_port_value(frequency_range_end_ports.at(n));
+        envelope_port_array.at(n) = lv2_wrapper->get_control_port_value(envelope_ports.at(n));
+        curve_port_array.at(n) = lv2_wrapper->get_control_port_value(curve_ports.at(n));
+        reduction_port_array.at(n) = lv2_wrapper->get_control_port_value(reduction_ports.at(n));
 
         // Normalize the current band gain reduction amount as a percentage,
         // where 0% is no gating, and 100% is a fully closed gate.
         // Double needed for the level bar widget.
         const double band_max_reduction_port_value =
-            static_cast<double>(lv2_wrapper->get_control_port_value("gr_" + nstr));
+            static_cast<double>(lv2_wrapper->get_control_port_value(max_reduction_ports.at(n)));
         // no reduction defaults to 1.0; aka db_to_linear(0 dB)
         gating_array.at(n) = util::normalize(reduction_port_array.at(n), band_max_reduction_port_value);
       }
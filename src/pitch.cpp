@@ -225,10 +225,7 @@ void Pitch::process(std::span<float>& left_in,
     apply_gain(left_in, right_in, input_gain);
   }
 
-  for (size_t n = 0U; n < left_in.size(); n++) {
-    data[n * 2U] = left_in[n];
-    data[n * 2U + 1U] = right_in[n];
-  }
+  simd::interleave(left_in, right_in, data);
 
   snd_touch->putSamples(data.data(), n_samples);
 
@@ -19,6 +19,8 @@
 
 #include "plugin_base.hpp"
 
+#include <semaphore>
+
 namespace {
 
 void on_process(void* userdata, spa_io_position* position) {
@@ -32,6 +34,14 @@ void on_process(void* userdata, spa_io_position* position) {
   }
 
   if (rate != d->pb->rate || n_samples != d->pb->n_samples) {
+    if (!d->pb->leave_async_mode()) {
+      // the worker is still busy with a block of the previous quantum
+
+      d->pb->output_silence(n_samples);
+
+      return;
+    }
+
     d->pb->rate = rate;
     d->pb->n_samples = n_samples;
 
@@ -43,17 +53,9 @@ void on_process(void* userdata, spa_io_position* position) {
 
     d->pb->clock_start = std::chrono::system_clock::now();
 
-    d->pb->setup();
+    d->pb->run_setup();
   }
 
-  d->pb->delta_t = 0.001F * static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                                   std::chrono::system_clock::now() - d->pb->clock_start)
-                                                   .count());
-
-  d->pb->send_notifications = d->pb->delta_t >= d->pb->notification_time_window;
-
-  // util::warning("processing: " + util::to_string(n_samples));
-
   auto* in_left = static_cast<float*>(pw_filter_get_dsp_buffer(d->in_left, n_samples));
   auto* in_right = static_cast<float*>(pw_filter_get_dsp_buffer(d->in_right, n_samples));
 
@@ -89,30 +91,20 @@ void on_process(void* userdata, spa_io_position* position) {
     right_out = d->pb->dummy_right;
   }
 
-  if (!d->pb->enable_probe) {
-    d->pb->process(left_in, right_in, left_out, right_out);
-  } else {
-    auto* probe_left = static_cast<float*>(pw_filter_get_dsp_buffer(d->probe_left, n_samples));
-    auto* probe_right = static_cast<float*>(pw_filter_get_dsp_buffer(d->probe_right, n_samples));
-
-    if (probe_left == nullptr || probe_right == nullptr) {
-      std::span l(d->pb->dummy_left.data(), n_samples);
-      std::span r(d->pb->dummy_right.data(), n_samples);
+  std::span<float> probe_left(d->pb->dummy_left.data(), n_samples);
+  std::span<float> probe_right(d->pb->dummy_right.data(), n_samples);
 
-      d->pb->process(left_in, right_in, left_out, right_out, l, r);
-    } else {
-      std::span l(probe_left, n_samples);
-      std::span r(probe_right, n_samples);
+  if (d->pb->enable_probe) {
+    auto* p_left = static_cast<float*>(pw_filter_get_dsp_buffer(d->probe_left, n_samples));
+    auto* p_right = static_cast<float*>(pw_filter_get_dsp_buffer(d->probe_right, n_samples));
 
-      d->pb->process(left_in, right_in, left_out, right_out, l, r);
+    if (p_left != nullptr && p_right != nullptr) {
+      probe_left = std::span(p_left, n_samples);
+      probe_right = std::span(p_right, n_samples);
     }
   }
 
-  if (d->pb->send_notifications) {
-    d->pb->clock_start = std::chrono::system_clock::now();
-
-    d->pb->send_notifications = false;
-  }
+  d->pb->process_cycle(position->clock.position, left_in, right_in, left_out, right_out, probe_left, probe_right);
 }
 
 auto update_filter(struct spa_loop* loop, bool async, uint32_t seq, const void* data, size_t size, void* user_data)
@@ -121,7 +113,8 @@ auto update_filter(struct spa_loop* loop, bool async, uint32_t seq, const void*
 
   spa_process_latency_info latency_info{};
 
-  latency_info.ns = static_cast<uint64_t>(self->latency_value * 1000000000.0F);
+  latency_info.ns =
+      static_cast<uint64_t>((self->latency_value + self->get_async_latency_seconds()) * 1000000000.0F);
 
   std::array<char, 1024U> buffer{};
 
@@ -166,6 +159,179 @@ const struct pw_filter_events filter_events = {.state_changed = on_filter_state_
 
 }  // namespace
 
+/*
+  The realtime thread copies each block to a free slot and wakes the worker. In the next graph cycle it outputs the
+  slot result if the worker finished it in time and silence otherwise. The slots are used in a fixed order and their
+  atomic state is the only synchronization between the threads. So the realtime thread never waits for the worker.
+
+  The slots are allocated in the main thread for the largest quantum PipeWire accepts by default. Bigger blocks are
+  processed synchronously. Before the quantum changes or the asynchronous mode is left the realtime thread increases
+  the generation counter and outputs silence until no slot is queued. The worker discards the blocks of an older
+  generation without processing them. So process() and setup() never run in both threads at the same time.
+*/
+
+class PluginBase::AsyncWorker {
+ public:
+  static constexpr uint max_block_size = 8192U;
+
+  AsyncWorker(PluginBase* plugin, const bool& enable_probe) : pb(plugin) {
+    for (auto& slot : slots) {
+      for (auto* v : {&slot.left_in, &slot.right_in, &slot.left_out, &slot.right_out}) {
+        v->resize(max_block_size);
+      }
+
+      if (enable_probe) {
+        slot.probe_left.resize(max_block_size);
+        slot.probe_right.resize(max_block_size);
+      }
+    }
+
+    thread = std::thread([this]() { work(); });
+  }
+
+  AsyncWorker(const AsyncWorker&) = delete;
+  auto operator=(const AsyncWorker&) -> AsyncWorker& = delete;
+  AsyncWorker(const AsyncWorker&&) = delete;
+  auto operator=(const AsyncWorker&&) -> AsyncWorker& = delete;
+
+  ~AsyncWorker() {
+    quit.store(true);
+
+    blocks_available.release();
+
+    thread.join();
+  }
+
+  void process(const uint64_t& position,
+               std::span<float>& left_in,
+               std::span<float>& right_in,
+               std::span<float>& left_out,
+               std::span<float>& right_out,
+               std::span<float>& probe_left,
+               std::span<float>& probe_right) {
+    const auto n_samples = left_in.size();
+
+    // the block handed to the worker in the previous cycle
+
+    if (has_pending && slots[pending_index].state.load(std::memory_order_acquire) == done) {
+      auto& slot = slots[pending_index];
+
+      std::copy_n(slot.left_out.begin(), n_samples, left_out.begin());
+      std::copy_n(slot.right_out.begin(), n_samples, right_out.begin());
+
+      slot.state.store(empty, std::memory_order_release);
+    } else {
+      std::ranges::fill(left_out, 0.0F);
+      std::ranges::fill(right_out, 0.0F);
+    }
+
+    has_pending = false;
+
+    // When the worker is so late that the next slot is still queued this block is dropped
+
+    auto& slot = slots[write_index];
+
+    if (slot.state.load(std::memory_order_acquire) == queued) {
+      return;
+    }
+
+    std::ranges::copy(left_in, slot.left_in.begin());
+    std::ranges::copy(right_in, slot.right_in.begin());
+
+    if (pb->enable_probe) {
+      std::ranges::copy(probe_left, slot.probe_left.begin());
+      std::ranges::copy(probe_right, slot.probe_right.begin());
+    }
+
+    slot.position = position;
+    slot.n_samples = n_samples;
+    slot.generation = generation.load(std::memory_order_relaxed);
+
+    slot.state.store(queued, std::memory_order_release);
+
+    pending_index = write_index;
+    has_pending = true;
+
+    write_index = (write_index + 1U) % n_slots;
+
+    blocks_available.release();
+  }
+
+  // Called by the realtime thread. The queued blocks are discarded and the pending result is not output anymore.
+  void drop_pending() {
+    generation.store(generation.load(std::memory_order_relaxed) + 1U, std::memory_order_release);
+
+    has_pending = false;
+  }
+
+  // True when the worker is not inside process() and has nothing queued
+  auto is_idle() -> bool {
+    return std::ranges::none_of(slots, [](const auto& slot) {
+      return slot.state.load(std::memory_order_acquire) == queued;
+    });
+  }
+
+ private:
+  enum State { empty, queued, done };
+
+  struct Slot {
+    std::atomic<int> state = empty;
+
+    uint64_t position = 0U;
+
+    size_t n_samples = 0U;
+
+    uint generation = 0U;
+
+    std::vector<float> left_in, right_in, left_out, right_out, probe_left, probe_right;
+  };
+
+  static constexpr size_t n_slots = 3U;
+
+  PluginBase* pb = nullptr;
+
+  std::array<Slot, n_slots> slots;
+
+  size_t write_index = 0U, pending_index = 0U;  // realtime thread
+
+  bool has_pending = false;
+
+  std::atomic<uint> generation = 0U;
+
+  std::atomic<bool> quit = false;
+
+  std::counting_semaphore<> blocks_available{0};
+
+  std::thread thread;
+
+  void work() {
+    size_t read_index = 0U;
+
+    while (true) {
+      blocks_available.acquire();
+
+      if (quit.load()) {
+        break;
+      }
+
+      auto& slot = slots[read_index];
+
+      read_index = (read_index + 1U) % n_slots;
+
+      if (slot.generation == generation.load(std::memory_order_acquire)) {
+        std::span<float> l_in(slot.left_in.data(), slot.n_samples), r_in(slot.right_in.data(), slot.n_samples),
+            l_out(slot.left_out.data(), slot.n_samples), r_out(slot.right_out.data(), slot.n_samples),
+            p_left(slot.probe_left.data(), slot.probe_left.empty() ? 0U : slot.n_samples),
+            p_right(slot.probe_right.data(), slot.probe_right.empty() ? 0U : slot.n_samples);
+
+        pb->run_process(slot.position, l_in, r_in, l_out, r_out, p_left, p_right);
+      }
+
+      slot.state.store(done, std::memory_order_release);
+    }
+  }
+};
+
 PluginBase::PluginBase(std::string tag,
                        std::string plugin_name,
                        std::string package,
@@ -184,15 +350,17 @@ PluginBase::PluginBase(std::string tag,
   if (name != "output_level" && name != "spectrum") {
     description = tags::plugin_name::get_translated()[name];
 
-    bypass = g_settings_get_boolean(settings, "bypass") != 0;
+    common_parameters.draft.bypass = g_settings_get_boolean(settings, "bypass") != 0;
 
     gconnections.push_back(g_signal_connect(settings, "changed::bypass",
                                             G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
                                               auto* self = static_cast<PluginBase*>(user_data);
 
-                                              self->bypass = g_settings_get_boolean(settings, "bypass") != 0;
+                                              self->set_bypass(g_settings_get_boolean(settings, "bypass") != 0);
                                             }),
                                             this));
+
+    common_parameters.publish();
   } else if (name == "output_level") {
     description = _("Output Level Meter");
   } else if (name == "spectrum") {
@@ -294,6 +462,10 @@ PluginBase::PluginBase(std::string tag,
 PluginBase::~PluginBase() {
   post_messages = false;
 
+  if (publish_source_id != 0U) {
+    g_source_remove(publish_source_id);
+  }
+
   pm->lock();
 
   if (listener.link.next != nullptr || listener.link.prev != nullptr) {
@@ -304,6 +476,8 @@ PluginBase::~PluginBase() {
 
   pm->sync_wait_unlock();
 
+  stop_async();
+
   for (auto& handler_id : gconnections) {
     g_signal_handler_disconnect(settings, handler_id);
   }
@@ -317,6 +491,35 @@ void PluginBase::set_post_messages(const bool& state) {
   post_messages = state;
 }
 
+void PluginBase::set_bypass(const bool& state) {
+  common_parameters.draft.bypass = state;
+
+  schedule_parameters_update();
+}
+
+void PluginBase::schedule_parameters_update() {
+  if (publish_source_id != 0U) {
+    return;
+  }
+
+  publish_source_id = g_idle_add_full(
+      G_PRIORITY_HIGH,
+      +[](gpointer user_data) {
+        auto* self = static_cast<PluginBase*>(user_data);
+
+        self->publish_source_id = 0U;
+
+        self->publish_parameters();
+
+        return G_SOURCE_REMOVE;
+      },
+      this, nullptr);
+}
+
+void PluginBase::publish_parameters() {
+  common_parameters.publish();
+}
+
 void PluginBase::reset_settings() {
   util::reset_all_keys_except(settings);
 }
@@ -326,6 +529,12 @@ auto PluginBase::connect_to_pw() -> bool {
   can_get_node_id = false;
   state = PW_FILTER_STATE_UNCONNECTED;
 
+  // the worker is stopped when the filter is disconnected
+
+  if (async_requested.load() && async_worker == nullptr) {
+    async_worker = std::make_unique<AsyncWorker>(this, enable_probe);
+  }
+
   pm->lock();
 
   if (pw_filter_connect(filter, PW_FILTER_FLAG_RT_PROCESS, nullptr, 0) != 0) {
@@ -401,6 +610,13 @@ void PluginBase::disconnect_from_pw() {
   pm->sync_wait_unlock();
 
   node_id = SPA_ID_INVALID;
+
+  /*
+    Derived destructors call this method before freeing their own members. So the block the worker may still be
+    processing finishes while the plugin state is intact.
+  */
+
+  stop_async();
 }
 
 void PluginBase::setup() {}
@@ -421,6 +637,164 @@ auto PluginBase::get_latency_seconds() -> float {
   return 0.0F;
 }
 
+void PluginBase::set_voice_activity(std::atomic<bool>* flag) {
+  voice_activity.store(flag);
+}
+
+void PluginBase::set_async(const bool& state) {
+  /*
+    The worker and its slots are created here and not in the realtime thread. The worker is only destroyed after the
+    filter is disconnected. So the realtime thread can use it once it sees the flag set.
+  */
+
+  if (state && async_worker == nullptr) {
+    async_worker = std::make_unique<AsyncWorker>(this, enable_probe);
+  }
+
+  async_requested.store(state, std::memory_order_release);
+}
+
+void PluginBase::stop_async() {
+  // The filter is not running. So the realtime thread can not give more blocks to the worker.
+
+  async_worker.reset();
+
+  async_active = false;
+
+  async_latency.store(0.0F, std::memory_order_relaxed);
+}
+
+auto PluginBase::get_async_latency_seconds() const -> float {
+  return async_latency.load(std::memory_order_relaxed);
+}
+
+void PluginBase::process_cycle(const uint64_t& position,
+                               std::span<float>& left_in,
+                               std::span<float>& right_in,
+                               std::span<float>& left_out,
+                               std::span<float>& right_out,
+                               std::span<float>& probe_left,
+                               std::span<float>& probe_right) {
+  if (!update_async_mode()) {
+    std::ranges::fill(left_out, 0.0F);
+    std::ranges::fill(right_out, 0.0F);
+
+    return;
+  }
+
+  if (async_active) {
+    async_worker->process(position, left_in, right_in, left_out, right_out, probe_left, probe_right);
+  } else {
+    run_process(position, left_in, right_in, left_out, right_out, probe_left, probe_right);
+  }
+}
+
+void PluginBase::run_setup() {
+  // the filter only changes the quantum after leave_async_mode() returned true
+
+  setup();
+}
+
+void PluginBase::output_silence(const uint& n_samples) const {
+  for (auto* port : {pf_data.out_left, pf_data.out_right}) {
+    if (auto* out = static_cast<float*>(pw_filter_get_dsp_buffer(port, n_samples)); out != nullptr) {
+      std::fill_n(out, n_samples, 0.0F);
+    }
+  }
+}
+
+auto PluginBase::update_async_mode() -> bool {
+  const auto requested = async_requested.load(std::memory_order_acquire) && n_samples <= AsyncWorker::max_block_size;
+
+  if (requested == async_active) {
+    return true;
+  }
+
+  if (!requested) {
+    return leave_async_mode();
+  }
+
+  async_active = true;
+
+  util::debug(log_tag + name + " asynchronous mode: on");
+
+  notify_async_latency();
+
+  return true;
+}
+
+auto PluginBase::leave_async_mode() -> bool {
+  if (!async_active) {
+    return true;
+  }
+
+  async_worker->drop_pending();
+
+  if (!async_worker->is_idle()) {
+    return false;
+  }
+
+  async_active = false;
+
+  util::debug(log_tag + name + " asynchronous mode: off");
+
+  notify_async_latency();
+
+  return true;
+}
+
+void PluginBase::notify_async_latency() {
+  async_latency.store((async_active) ? static_cast<float>(n_samples) / static_cast<float>(rate) : 0.0F,
+                      std::memory_order_relaxed);
+
+  util::idle_add([=, this]() {
+    if (!post_messages || latency.empty()) {
+      return;
+    }
+
+    latency.emit();
+  });
+
+  update_filter_params();
+}
+
+void PluginBase::run_process(const uint64_t& position,
+                             std::span<float>& left_in,
+                             std::span<float>& right_in,
+                             std::span<float>& left_out,
+                             std::span<float>& right_out,
+                             std::span<float>& probe_left,
+                             std::span<float>& probe_right) {
+  clock_position = position;
+
+  // all the parameters published since the last block are taken at once
+
+  const auto& parameters = common_parameters.read();
+
+  bypass = parameters.bypass;
+  input_gain = parameters.input_gain;
+  output_gain = parameters.output_gain;
+
+  delta_t = 0.001F *
+            static_cast<float>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - clock_start)
+                    .count());
+
+  send_notifications = delta_t >= notification_time_window;
+
+  if (!enable_probe) {
+    process(left_in, right_in, left_out, right_out);
+  } else {
+    process(left_in, right_in, left_out, right_out, probe_left, probe_right);
+  }
+
+  if (send_notifications) {
+    clock_start = std::chrono::system_clock::now();
+
+    send_notifications = false;
+  }
+}
+
 void PluginBase::show_native_ui() {
   if (lv2_wrapper == nullptr) {
     return;
@@ -458,39 +832,51 @@ void PluginBase::get_peaks(const std::span<float>& left_in,
 
   // input level
 
-  float peak_l = std::ranges::max(left_in);
-  float peak_r = std::ranges::max(right_in);
+  float peak_l = simd::max(left_in);
+  float peak_r = simd::max(right_in);
 
   input_peak_left = (peak_l > input_peak_left) ? peak_l : input_peak_left;
   input_peak_right = (peak_r > input_peak_right) ? peak_r : input_peak_right;
 
   // output level
 
-  peak_l = std::ranges::max(left_out);
-  peak_r = std::ranges::max(right_out);
+  peak_l = simd::max(left_out);
+  peak_r = simd::max(right_out);
 
   output_peak_left = (peak_l > output_peak_left) ? peak_l : output_peak_left;
   output_peak_right = (peak_r > output_peak_right) ? peak_r : output_peak_right;
 }
 
 void PluginBase::setup_input_output_gain() {
-  input_gain = static_cast<float>(util::db_to_linear(g_settings_get_double(settings, "input-gain")));
-  output_gain = static_cast<float>(util::db_to_linear(g_settings_get_double(settings, "output-gain")));
+  common_parameters.draft.input_gain =
+      static_cast<float>(util::db_to_linear(g_settings_get_double(settings, "input-gain")));
+
+  common_parameters.draft.output_gain =
+      static_cast<float>(util::db_to_linear(g_settings_get_double(settings, "output-gain")));
+
+  common_parameters.publish();
+
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::input-gain", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<PluginBase*>(user_data);
 
-  g_signal_connect(settings, "changed::input-gain", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                     auto* self = static_cast<PluginBase*>(user_data);
+        self->common_parameters.draft.input_gain =
+            static_cast<float>(util::db_to_linear(g_settings_get_double(settings, key)));
 
-                     self->input_gain = util::db_to_linear(g_settings_get_double(settings, key));
-                   }),
-                   this);
+        self->schedule_parameters_update();
+      }),
+      this));
 
-  g_signal_connect(settings, "changed::output-gain",
-                   G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
-                     auto* self = static_cast<PluginBase*>(user_data);
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::output-gain", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<PluginBase*>(user_data);
 
-                     self->output_gain = util::db_to_linear(g_settings_get_double(settings, key));
-                   }),
-                   this);
+        self->common_parameters.draft.output_gain =
+            static_cast<float>(util::db_to_linear(g_settings_get_double(settings, key)));
+
+        self->schedule_parameters_update();
+      }),
+      this));
 }
 
 void PluginBase::apply_gain(std::span<float>& left, std::span<float>& right, const float& gain) {
@@ -498,8 +884,53 @@ void PluginBase::apply_gain(std::span<float>& left, std::span<float>& right, con
     return;
   }
 
-  std::ranges::for_each(left, [&](auto& v) { v *= gain; });
-  std::ranges::for_each(right, [&](auto& v) { v *= gain; });
+  simd::scale(left, gain);
+  simd::scale(right, gain);
+}
+
+auto PluginBase::skip_without_voice(std::span<float>& left_in,
+                                    std::span<float>& right_in,
+                                    std::span<float>& left_out,
+                                    std::span<float>& right_out) -> bool {
+  const auto* flag = voice_activity.load(std::memory_order_relaxed);
+
+  voice_present = flag == nullptr || flag->load(std::memory_order_relaxed);
+
+  if (voice_present || voice_gain != 0.0F) {
+    return false;
+  }
+
+  std::ranges::fill(left_out, 0.0F);
+  std::ranges::fill(right_out, 0.0F);
+
+  if (post_messages) {
+    get_peaks(left_in, right_in, left_out, right_out);
+
+    if (send_notifications) {
+      notify();
+    }
+  }
+
+  return true;
+}
+
+void PluginBase::fade_without_voice(std::span<float>& left_out, std::span<float>& right_out) {
+  const float target = (voice_present) ? 1.0F : 0.0F;
+
+  if (voice_gain == target) {
+    return;
+  }
+
+  const float step = (target - voice_gain) / static_cast<float>(left_out.size());
+
+  for (size_t n = 0U; n < left_out.size(); n++) {
+    const float g = voice_gain + step * static_cast<float>(n + 1U);
+
+    left_out[n] *= g;
+    right_out[n] *= g;
+  }
+
+  voice_gain = target;
 }
 
 void PluginBase::notify() {
@@ -334,6 +334,14 @@ void add_plugins_to_stack(PluginsBox* self) {
       }
 
       gtk_stack_add_named(self->stack, box, name.c_str());
+    } else if (name.starts_with(tags::plugin_name::lv2_plugin)) {
+      auto plugin_ptr = effects_base->get_plugin_instance<Lv2Plugin>(name);
+
+      auto* box = ui::lv2_plugin_box::create();
+
+      ui::lv2_plugin_box::setup(box, plugin_ptr, path);
+
+      gtk_stack_add_named(self->stack, GTK_WIDGET(box), name.c_str());
     } else if (GtkWidget* box = nullptr; name.starts_with(tags::plugin_name::maximizer)) {
       auto plugin_ptr = effects_base->get_plugin_instance<Maximizer>(name);
 
@@ -27,7 +27,8 @@ struct _PreferencesGeneral {
   AdwPreferencesPage parent_instance;
 
   GtkSwitch *enable_autostart, *process_all_inputs, *process_all_outputs, *theme_switch, *shutdown_on_window_close,
-      *use_cubic_volumes, *autohide_popovers, *exclude_monitor_streams, *show_native_plugin_ui;
+      *use_cubic_volumes, *autohide_popovers, *exclude_monitor_streams, *show_native_plugin_ui,
+      *offload_heavy_plugins;
 
   GtkSpinButton *inactivity_timeout, *meters_update_interval, *lv2ui_update_frequency;
 
@@ -113,6 +114,7 @@ void preferences_general_class_init(PreferencesGeneralClass* klass) {
   gtk_widget_class_bind_template_child(widget_class, PreferencesGeneral, meters_update_interval);
   gtk_widget_class_bind_template_child(widget_class, PreferencesGeneral, lv2ui_update_frequency);
   gtk_widget_class_bind_template_child(widget_class, PreferencesGeneral, show_native_plugin_ui);
+  gtk_widget_class_bind_template_child(widget_class, PreferencesGeneral, offload_heavy_plugins);
 }
 
 void preferences_general_init(PreferencesGeneral* self) {
@@ -128,11 +130,12 @@ void preferences_general_init(PreferencesGeneral* self) {
 
   gsettings_bind_widgets<"process-all-inputs", "process-all-outputs", "use-dark-theme", "shutdown-on-window-close",
                          "use-cubic-volumes", "autohide-popovers", "exclude-monitor-streams", "inactivity-timeout",
-                         "meters-update-interval", "lv2ui-update-frequency", "show-native-plugin-ui">(
+                         "meters-update-interval", "lv2ui-update-frequency", "show-native-plugin-ui",
+                         "offload-heavy-plugins">(
       self->settings, self->process_all_inputs, self->process_all_outputs, self->theme_switch,
       self->shutdown_on_window_close, self->use_cubic_volumes, self->autohide_popovers, self->exclude_monitor_streams,
       self->inactivity_timeout, self->meters_update_interval, self->lv2ui_update_frequency,
-      self->show_native_plugin_ui);
+      self->show_native_plugin_ui, self->offload_heavy_plugins);
 
 #ifdef ENABLE_LIBPORTAL
   libportal::init(self->enable_autostart, self->shutdown_on_window_close);
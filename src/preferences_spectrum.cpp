@@ -35,9 +35,9 @@ struct _PreferencesSpectrum {
 
   GtkColorDialogButton *color_button, *axis_color_button;
 
-  GtkDropDown* type;
+  GtkDropDown *type, *fft_size, *mode;
 
-  GtkSpinButton *n_points, *height, *line_width, *minimum_frequency, *maximum_frequency;
+  GtkSpinButton *n_points, *height, *line_width, *minimum_frequency, *maximum_frequency, *overlap;
 
   GSettings* settings;
 
@@ -106,6 +106,9 @@ void preferences_spectrum_class_init(PreferencesSpectrumClass* klass) {
   gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, axis_color_button);
   gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, minimum_frequency);
   gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, maximum_frequency);
+  gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, fft_size);
+  gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, mode);
+  gtk_widget_class_bind_template_child(widget_class, PreferencesSpectrum, overlap);
 
   gtk_widget_class_bind_template_callback(widget_class, on_spectrum_color_set);
   gtk_widget_class_bind_template_callback(widget_class, on_spectrum_axis_color_set);
@@ -132,6 +135,8 @@ void preferences_spectrum_init(PreferencesSpectrum* self) {
 
   prepare_spinbuttons<"px">(self->height, self->line_width);
 
+  prepare_spinbuttons<"%">(self->overlap);
+
   g_signal_connect(self->minimum_frequency, "output", G_CALLBACK(+[](GtkSpinButton* button, gpointer user_data) {
                      return parse_spinbutton_output(button, "Hz");
                    }),
@@ -193,8 +198,12 @@ void preferences_spectrum_init(PreferencesSpectrum* self) {
                   G_SETTINGS_BIND_DEFAULT);
   g_settings_bind(self->settings, "maximum-frequency", gtk_spin_button_get_adjustment(self->maximum_frequency), "value",
                   G_SETTINGS_BIND_DEFAULT);
+  g_settings_bind(self->settings, "overlap", gtk_spin_button_get_adjustment(self->overlap), "value",
+                  G_SETTINGS_BIND_DEFAULT);
 
   ui::gsettings_bind_enum_to_combo_widget(self->settings, "type", self->type);
+  ui::gsettings_bind_enum_to_combo_widget(self->settings, "fft-size", self->fft_size);
+  ui::gsettings_bind_enum_to_combo_widget(self->settings, "mode", self->mode);
 
   // Spectrum gsettings signals connections
 
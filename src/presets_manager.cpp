@@ -255,7 +255,7 @@ auto PresetsManager::load_blocklist(const PresetType& preset_type, const nlohman
       try {
         auto list = json.at("input").at("blocklist").get<std::vector<std::string>>();
 
-        g_settings_set_strv(sie_settings, "blocklist", util::make_gchar_pointer_vector(list).data());
+        update_string_list(sie_settings, "blocklist", list);
       } catch (const nlohmann::json::exception& e) {
         g_settings_reset(sie_settings, "blocklist");
 
@@ -278,7 +278,7 @@ auto PresetsManager::load_blocklist(const PresetType& preset_type, const nlohman
       try {
         auto list = json.at("output").at("blocklist").get<std::vector<std::string>>();
 
-        g_settings_set_strv(soe_settings, "blocklist", util::make_gchar_pointer_vector(list).data());
+        update_string_list(soe_settings, "blocklist", list);
       } catch (const nlohmann::json::exception& e) {
         g_settings_reset(soe_settings, "blocklist");
 
@@ -447,7 +447,7 @@ auto PresetsManager::load_preset_file(const PresetType& preset_type, const std::
           return false;
         }
 
-        g_settings_set_strv(soe_settings, "plugins", util::make_gchar_pointer_vector(plugins).data());
+        update_plugins_order(soe_settings, plugins);
       } else {
         util::debug("can't find the preset " + name + " on the filesystem");
 
@@ -506,7 +506,7 @@ auto PresetsManager::load_preset_file(const PresetType& preset_type, const std::
           return false;
         }
 
-        g_settings_set_strv(sie_settings, "plugins", util::make_gchar_pointer_vector(plugins).data());
+        update_plugins_order(sie_settings, plugins);
       } else {
         util::debug("can't find the preset " + name + " on the filesystem");
 
@@ -526,6 +526,29 @@ auto PresetsManager::load_preset_file(const PresetType& preset_type, const std::
   return false;
 }
 
+auto PresetsManager::update_string_list(GSettings* settings, const char* key, const std::vector<std::string>& list)
+    -> bool {
+  if (util::gchar_array_to_vector(g_settings_get_strv(settings, key)) == list) {
+    return false;
+  }
+
+  g_settings_set_strv(settings, key, util::make_gchar_pointer_vector(list).data());
+
+  return true;
+}
+
+void PresetsManager::update_plugins_order(GSettings* effects_settings, const std::vector<std::string>& plugins) {
+  /*
+    Writing the same order again would make the effects relink the whole chain. When it did not change the plugins
+    stay linked and only the keys that differ are written by read_plugins_preset. Like a new chain would do, loading a
+    preset still disables the global bypass.
+  */
+
+  if (!update_string_list(effects_settings, "plugins", plugins) && g_settings_get_boolean(settings, "bypass") != 0) {
+    g_settings_set_boolean(settings, "bypass", 0);
+  }
+}
+
 auto PresetsManager::read_plugins_preset(const PresetType& preset_type,
                                          const std::vector<std::string>& plugins,
                                          const nlohmann::json& json) -> bool {
@@ -894,6 +917,10 @@ auto PresetsManager::create_wrapper(const PresetType& preset_type, std::string_v
     return std::make_unique<LoudnessPreset>(preset_type, instance_id);
   }
 
+  if (filter_name.starts_with(tags::plugin_name::lv2_plugin)) {
+    return std::make_unique<Lv2PluginPreset>(preset_type, instance_id);
+  }
+
   if (filter_name.starts_with(tags::plugin_name::maximizer)) {
     return std::make_unique<MaximizerPreset>(preset_type, instance_id);
   }
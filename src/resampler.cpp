@@ -19,10 +19,36 @@
 
 #include "resampler.hpp"
 
-Resampler::Resampler(const int& input_rate, const int& output_rate) : output(1, 0) {
-  resample_ratio = static_cast<float>(output_rate) / static_cast<float>(input_rate);
+#include <algorithm>
+#include "util.hpp"
 
-  src_state = src_new(SRC_SINC_FASTEST, 1, nullptr);
+Resampler::Resampler(const int& input_rate, const int& output_rate, const int& n_channels, const Quality& quality)
+    : channels(std::max(n_channels, 1)) {
+  resample_ratio = static_cast<double>(output_rate) / static_cast<double>(input_rate);
+
+  int converter = SRC_SINC_FASTEST;
+
+  switch (quality) {
+    case Quality::fastest:
+      converter = SRC_SINC_FASTEST;
+      break;
+    case Quality::medium:
+      converter = SRC_SINC_MEDIUM_QUALITY;
+      break;
+    case Quality::best:
+      converter = SRC_SINC_BEST_QUALITY;
+      break;
+  }
+
+  int error = 0;
+
+  src_state = src_new(converter, channels, &error);
+
+  if (src_state == nullptr) {
+    util::warning("failed to create the resampler: " + std::string(src_strerror(error)));
+  }
+
+  measure_delay(converter);
 }
 
 Resampler::~Resampler() {
@@ -30,3 +56,67 @@ Resampler::~Resampler() {
     src_delete(src_state);
   }
 }
+
+auto Resampler::process(std::span<const float> input, std::span<float> output) -> size_t {
+  if (src_state == nullptr) {
+    return 0U;
+  }
+
+  const auto n_channels = static_cast<size_t>(channels);
+
+  src_data.input_frames = static_cast<long>(input.size() / n_channels);
+  src_data.data_in = input.data();
+
+  src_data.output_frames = static_cast<long>(output.size() / n_channels);
+  src_data.data_out = output.data();
+
+  src_data.src_ratio = resample_ratio;
+  src_data.end_of_input = 0;
+
+  if (src_process(src_state, &src_data) != 0) {
+    return 0U;
+  }
+
+  return static_cast<size_t>(src_data.output_frames_gen);
+}
+
+void Resampler::measure_delay(const int& converter) {
+  // The delay is where the peak of the impulse response shows up in the output. It allocates memory.
+
+  std::vector<float> impulse(4096U, 0.0F);
+
+  impulse[0] = 1.0F;
+
+  std::vector<float> response(get_max_output_frames(impulse.size()));
+
+  SRC_DATA data{};
+
+  data.data_in = impulse.data();
+  data.input_frames = static_cast<long>(impulse.size());
+
+  data.data_out = response.data();
+  data.output_frames = static_cast<long>(response.size());
+
+  data.src_ratio = resample_ratio;
+  data.end_of_input = 1;
+
+  if (src_simple(&data, converter, 1) != 0 || data.output_frames_gen <= 0) {
+    return;
+  }
+
+  const auto generated = std::span(response).first(static_cast<size_t>(data.output_frames_gen));
+
+  const auto peak = std::ranges::max_element(generated, {}, [](const auto& v) { return std::fabs(v); });
+
+  delay_frames = static_cast<size_t>(std::distance(generated.begin(), peak));
+}
+
+auto Resampler::get_delay_frames() const -> size_t {
+  return delay_frames;
+}
+
+auto Resampler::get_max_output_frames(const size_t& input_frames) const -> size_t {
+  // libsamplerate may return a few frames more than the ratio suggests when it has filter history to flush
+
+  return static_cast<size_t>(std::ceil(1.5 * resample_ratio * static_cast<double>(input_frames))) + 16U;
+}
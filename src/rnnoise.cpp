@@ -19,16 +19,66 @@
 
 #include "rnnoise.hpp"
 
+#include <numeric>
+
 RNNoise::RNNoise(const std::string& tag,
                  const std::string& schema,
                  const std::string& schema_path,
                  PipeManager* pipe_manager)
     : PluginBase(tag, tags::plugin_name::rnnoise, tags::plugin_package::rnnoise, schema, schema_path, pipe_manager),
       data_L(0),
-      data_R(0) {
+      data_R(0),
+      data_mid(blocksize),
+      delayed_L(blocksize),
+      delayed_R(blocksize),
+      delayed_mid(blocksize) {
   data_L.reserve(blocksize);
   data_R.reserve(blocksize);
 
+  channel_mode = parse_channel_mode_key(util::gsettings_get_string(settings, "channel-mode"));
+
+  vad_gate = g_settings_get_boolean(settings, "enable-vad-gate") != 0;
+
+  vad_threshold = 0.01F * static_cast<float>(g_settings_get_int(settings, "vad-threshold"));
+
+  set_vad_hangover(g_settings_get_int(settings, "vad-hangover"));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::enable-vad-gate",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<RNNoise*>(user_data);
+
+                                            self->vad_gate = g_settings_get_boolean(settings, key) != 0;
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::vad-threshold", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<RNNoise*>(user_data);
+
+        self->vad_threshold = 0.01F * static_cast<float>(g_settings_get_int(settings, key));
+      }),
+      this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::vad-hangover",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<RNNoise*>(user_data);
+
+                                            self->set_vad_hangover(g_settings_get_int(settings, key));
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::channel-mode", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<RNNoise*>(user_data);
+
+        std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+        self->channel_mode = parse_channel_mode_key(util::gsettings_get_string(settings, key));
+
+        self->reset_linked_state();
+      }),
+      this));
+
   gconnections.push_back(g_signal_connect(settings, "changed::model-path",
                                           G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
                                             auto* self = static_cast<RNNoise*>(user_data);
@@ -93,22 +143,77 @@ void RNNoise::setup() {
   resampler_ready = false;
 
   latency_n_frames = 0U;
+  resampler_delay_frames = 0U;
 
   resample = rate != rnnoise_rate;
 
   data_L.resize(0U);
   data_R.resize(0U);
 
+  reset_linked_state();
+
+  voice_detected = true;
+  vad_hangover_count = 0U;
+  vad_probability = 0.0F;
+  gate_gain = 1.0F;
+  voice_history = 0U;
+
   deque_out_L.resize(0U);
   deque_out_R.resize(0U);
 
-  resampler_inL = std::make_unique<Resampler>(rate, rnnoise_rate);
-  resampler_inR = std::make_unique<Resampler>(rate, rnnoise_rate);
+  notify_latency = resample;
+
+  if (!resample) {
+    return;
+  }
+
+  /*
+    Creating the resamplers and sizing their buffers allocates memory. So it is done in the main thread. The input
+    passes through until then.
+  */
+
+  util::idle_add([this, rate = rate, n_samples = n_samples]() {
+    auto new_resampler_in = std::make_unique<Resampler>(rate, rnnoise_rate, 2);
+    auto new_resampler_out = std::make_unique<Resampler>(rnnoise_rate, rate, 2);
+
+    std::scoped_lock<std::mutex> lock(data_mutex);
+
+    if (rate != this->rate || n_samples != this->n_samples) {
+      return;  // a newer setup scheduled its own resamplers
+    }
+
+    resampler_in = std::move(new_resampler_in);
+    resampler_out = std::move(new_resampler_out);
+
+    // the delay of the first stage is measured at the rnnoise rate
+
+    const auto delay_in = static_cast<double>(resampler_in->get_delay_frames()) * static_cast<double>(rate) /
+                          static_cast<double>(rnnoise_rate);
 
-  resampler_outL = std::make_unique<Resampler>(rnnoise_rate, rate);
-  resampler_outR = std::make_unique<Resampler>(rnnoise_rate, rate);
+    resampler_delay_frames = static_cast<uint>(std::lround(delay_in)) + resampler_out->get_delay_frames();
 
-  resampler_ready = true;
+    notify_latency = true;
+
+    const auto max_resampled_in = resampler_in->get_max_output_frames(n_samples);
+
+    // remove_noise may output one more block than it received when it completes a block left from the last cycle
+    const auto max_denoised = max_resampled_in + blocksize;
+
+    const auto max_resampled_out = resampler_out->get_max_output_frames(max_denoised);
+
+    interleaved_in.resize(2U * n_samples);
+    resampled_in.resize(2U * max_resampled_in);
+    resampled_inL.resize(max_resampled_in);
+    resampled_inR.resize(max_resampled_in);
+
+    resampled_data_L.reserve(max_denoised);
+    resampled_data_R.reserve(max_denoised);
+
+    interleaved_out.resize(2U * max_denoised);
+    resampled_out.resize(2U * max_resampled_out);
+
+    resampler_ready = true;
+  });
 }
 
 void RNNoise::process(std::span<float>& left_in,
@@ -121,6 +226,8 @@ void RNNoise::process(std::span<float>& left_in,
     std::copy(left_in.begin(), left_in.end(), left_out.begin());
     std::copy(right_in.begin(), right_in.end(), right_out.begin());
 
+    publish_voice_activity(true);
+
     return;
   }
 
@@ -130,25 +237,35 @@ void RNNoise::process(std::span<float>& left_in,
 
   if (resample) {
     if (resampler_ready) {
-      const auto resampled_inL = resampler_inL->process(left_in, false);
-      const auto resampled_inR = resampler_inR->process(right_in, false);
+      const auto n_in = left_in.size();
+
+      simd::interleave(left_in, right_in, std::span(interleaved_in).first(2U * n_in));
+
+      const auto n_resampled =
+          resampler_in->process(std::span<const float>(interleaved_in).first(2U * n_in), resampled_in);
+
+      auto inL = std::span(resampled_inL).first(n_resampled);
+      auto inR = std::span(resampled_inR).first(n_resampled);
+
+      simd::deinterleave(std::span<const float>(resampled_in).first(2U * n_resampled), inL, inR);
 
       resampled_data_L.resize(0U);
       resampled_data_R.resize(0U);
 
 #ifdef ENABLE_RNNOISE
-      remove_noise(resampled_inL, resampled_inR, resampled_data_L, resampled_data_R);
+      remove_noise(inL, inR, resampled_data_L, resampled_data_R);
 #endif
 
-      auto resampled_outL = resampler_outL->process(resampled_data_L, false);
-      auto resampled_outR = resampler_outR->process(resampled_data_R, false);
+      const auto n_denoised = resampled_data_L.size();
 
-      for (const auto& v : resampled_outL) {
-        deque_out_L.push_back(v);
-      }
+      simd::interleave(resampled_data_L, resampled_data_R, std::span(interleaved_out).first(2U * n_denoised));
 
-      for (const auto& v : resampled_outR) {
-        deque_out_R.push_back(v);
+      const auto n_out =
+          resampler_out->process(std::span<const float>(interleaved_out).first(2U * n_denoised), resampled_out);
+
+      for (size_t n = 0U; n < n_out; n++) {
+        deque_out_L.push_back(resampled_out[2U * n]);
+        deque_out_R.push_back(resampled_out[2U * n + 1U]);
       }
     } else {
       for (const auto& v : left_in) {
@@ -205,7 +322,7 @@ void RNNoise::process(std::span<float>& left_in,
   }
 
   if (notify_latency) {
-    latency_value = static_cast<float>(latency_n_frames) / static_cast<float>(rate);
+    latency_value = static_cast<float>(latency_n_frames + resampler_delay_frames) / static_cast<float>(rate);
 
     util::debug(log_tag + name + " latency: " + util::to_string(latency_value, "") + " s");
 
@@ -222,17 +339,212 @@ void RNNoise::process(std::span<float>& left_in,
     notify_latency = false;
   }
 
+  publish_voice_activity(!vad_gate || voice_detected);
+
   if (post_messages) {
     get_peaks(left_in, right_in, left_out, right_out);
 
     if (send_notifications) {
+      voice_probability.emit(vad_probability);
+
       notify();
     }
   }
 }
 
+void RNNoise::set_voice_activity_output(std::atomic<bool>* flag) {
+  std::scoped_lock<std::mutex> lock(data_mutex);
+
+  voice_activity_output = flag;
+
+  publish_voice_activity(true);
+}
+
+void RNNoise::publish_voice_activity(const bool& active) {
+  /*
+    Our output is behind the decision by the plugin latency. So a pause is only published when the decision stayed
+    negative for the blocks needed to output the last voiced one. Otherwise the plugins after us would cut its end.
+  */
+
+  voice_history = (voice_history << 1U) | static_cast<uint64_t>(active);
+
+  uint delay_blocks = 0U;
+
+  if (n_samples != 0U) {
+    const auto latency_frames = static_cast<uint>(std::ceil(latency_value * static_cast<float>(rate)));
+
+    delay_blocks = std::min((latency_frames + n_samples - 1U) / n_samples, 62U);
+  }
+
+  const uint64_t window = (uint64_t{2U} << delay_blocks) - 1U;
+
+  if (voice_activity_output != nullptr) {
+    voice_activity_output->store((voice_history & window) != 0U, std::memory_order_relaxed);
+  }
+}
+
+void RNNoise::set_vad_hangover(const int& milliseconds) {
+  // rnnoise blocks always have 10 ms
+
+  vad_hangover_blocks = static_cast<uint>(milliseconds) * rnnoise_rate / (1000U * blocksize);
+}
+
+void RNNoise::update_voice_activity(const float& probability) {
+  // Instantaneous attack and a short release so that the gate does not chatter between syllables
+
+  vad_probability = (probability > vad_probability) ? probability
+                                                    : vad_probability + vad_release * (probability - vad_probability);
+
+  if (vad_probability >= vad_threshold) {
+    voice_detected = true;
+
+    vad_hangover_count = vad_hangover_blocks;
+  } else if (vad_hangover_count > 0U) {
+    vad_hangover_count--;
+  } else {
+    voice_detected = false;
+  }
+
+  const float target = (!vad_gate || voice_detected) ? 1.0F : 0.0F;
+
+  if (target == 1.0F && gate_gain == 1.0F) {
+    return;
+  }
+
+  const float step = (target - gate_gain) / static_cast<float>(blocksize);
+
+  for (uint n = 0U; n < blocksize; n++) {
+    const float g = gate_gain + step * static_cast<float>(n + 1U);
+
+    data_L[n] *= g;
+    data_R[n] *= g;
+  }
+
+  gate_gain = target;
+}
+
+auto RNNoise::parse_channel_mode_key(const std::string& key) -> ChannelMode {
+  if (key == "Stereo Linked") {
+    return ChannelMode::linked;
+  }
+
+  if (key == "Mono Sum") {
+    return ChannelMode::mono_sum;
+  }
+
+  return ChannelMode::independent;
+}
+
+void RNNoise::reset_linked_state() {
+  std::ranges::fill(delayed_L, 0.0F);
+  std::ranges::fill(delayed_R, 0.0F);
+  std::ranges::fill(delayed_mid, 0.0F);
+
+  linked_gain = 1.0F;
+}
+
 #ifdef ENABLE_RNNOISE
 
+void RNNoise::denoise_block() {
+  float probability = 0.0F;
+
+  switch (channel_mode) {
+    case ChannelMode::independent: {
+      if (state_left != nullptr) {
+        simd::scale(data_L, static_cast<float>(SHRT_MAX + 1));
+
+        probability = rnnoise_process_frame(state_left, data_L.data(), data_L.data());
+
+        simd::scale(data_L, inv_short_max);
+      }
+
+      if (state_right != nullptr) {
+        simd::scale(data_R, static_cast<float>(SHRT_MAX + 1));
+
+        probability = std::max(probability, rnnoise_process_frame(state_right, data_R.data(), data_R.data()));
+
+        simd::scale(data_R, inv_short_max);
+      }
+
+      break;
+    }
+    case ChannelMode::mono_sum: {
+      if (state_left == nullptr) {
+        break;
+      }
+
+      simd::mix(data_L, data_R, 0.5F * static_cast<float>(SHRT_MAX + 1), data_mid);
+
+      probability = rnnoise_process_frame(state_left, data_mid.data(), data_mid.data());
+
+      simd::scale(data_mid, inv_short_max);
+
+      std::ranges::copy(data_mid, data_L.begin());
+      std::ranges::copy(data_mid, data_R.begin());
+
+      break;
+    }
+    case ChannelMode::linked: {
+      if (state_left != nullptr) {
+        probability = denoise_block_linked();
+      }
+
+      break;
+    }
+  }
+
+  update_voice_activity(probability);
+}
+
+auto RNNoise::denoise_block_linked() -> float {
+  /*
+    The rnnoise library does not expose the gains of its bands. So we denoise only the mid signal and apply the
+    energy ratio between its output and its input to both channels. The stereo image is preserved and the network
+    runs once per block.
+  */
+
+  simd::mix(data_L, data_R, 0.5F * static_cast<float>(SHRT_MAX + 1), data_mid);
+
+  // rnnoise outputs the block it received in the previous call
+
+  const auto energy_in = std::inner_product(delayed_mid.begin(), delayed_mid.end(), delayed_mid.begin(), 0.0);
+
+  std::ranges::copy(data_mid, delayed_mid.begin());
+
+  const auto probability = rnnoise_process_frame(state_left, data_mid.data(), data_mid.data());
+
+  const auto energy_out = std::inner_product(data_mid.begin(), data_mid.end(), data_mid.begin(), 0.0);
+
+  // Below one 16 bits step the ratio is meaningless and we keep the last gain
+
+  auto gain = linked_gain;
+
+  if (energy_in > static_cast<double>(blocksize)) {
+    gain = static_cast<float>(std::min(std::sqrt(energy_out / energy_in), 1.0));
+  }
+
+  // Linear interpolation avoids clicks when the gain changes between blocks
+
+  const float step = (gain - linked_gain) / static_cast<float>(blocksize);
+
+  for (uint n = 0U; n < blocksize; n++) {
+    const float g = linked_gain + step * static_cast<float>(n + 1U);
+
+    const float L = delayed_L[n] * g;
+    const float R = delayed_R[n] * g;
+
+    delayed_L[n] = data_L[n];
+    delayed_R[n] = data_R[n];
+
+    data_L[n] = L;
+    data_R[n] = R;
+  }
+
+  linked_gain = gain;
+
+  return probability;
+}
+
 auto RNNoise::get_model_from_file() -> RNNModel* {
   RNNModel* m = nullptr;
 
@@ -35,6 +35,14 @@ void RNNoisePreset::save(nlohmann::json& json) {
 
   json[section][instance_name]["output-gain"] = g_settings_get_double(settings, "output-gain");
 
+  json[section][instance_name]["channel-mode"] = util::gsettings_get_string(settings, "channel-mode");
+
+  json[section][instance_name]["enable-vad-gate"] = g_settings_get_boolean(settings, "enable-vad-gate") != 0;
+
+  json[section][instance_name]["vad-threshold"] = g_settings_get_int(settings, "vad-threshold");
+
+  json[section][instance_name]["vad-hangover"] = g_settings_get_int(settings, "vad-hangover");
+
   json[section][instance_name]["model-path"] = util::gsettings_get_string(settings, "model-path");
 }
 
@@ -45,5 +53,13 @@ void RNNoisePreset::load(const nlohmann::json& json) {
 
   update_key<double>(json.at(section).at(instance_name), settings, "output-gain", "output-gain");
 
+  update_key<gchar*>(json.at(section).at(instance_name), settings, "channel-mode", "channel-mode");
+
+  update_key<bool>(json.at(section).at(instance_name), settings, "enable-vad-gate", "enable-vad-gate");
+
+  update_key<int>(json.at(section).at(instance_name), settings, "vad-threshold", "vad-threshold");
+
+  update_key<int>(json.at(section).at(instance_name), settings, "vad-hangover", "vad-hangover");
+
   update_key<gchar*>(json.at(section).at(instance_name), settings, "model-path", "model-path");
 }
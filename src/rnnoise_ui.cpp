@@ -56,6 +56,16 @@ struct _RNNoiseBox {
 
   GtkScale *input_gain, *output_gain;
 
+  GtkDropDown* channel_mode;
+
+  GtkSwitch* enable_vad_gate;
+
+  GtkSpinButton *vad_threshold, *vad_hangover;
+
+  GtkLevelBar* vad_level;
+
+  GtkLabel* vad_label;
+
   GtkLevelBar *input_level_left, *input_level_right, *output_level_left, *output_level_right;
 
   GtkLabel *active_model_name, *model_active_state, *model_error_state, *input_level_left_label,
@@ -248,10 +258,30 @@ void setup(RNNoiseBox* self,
     });
   }));
 
+  self->data->connections.push_back(rnnoise->voice_probability.connect([=](const float value) {
+    util::idle_add([=]() {
+      if (get_ignore_filter_idle_add(serial)) {
+        return;
+      }
+
+      if (!GTK_IS_LEVEL_BAR(self->vad_level) || !GTK_IS_LABEL(self->vad_label)) {
+        return;
+      }
+
+      gtk_level_bar_set_value(self->vad_level, static_cast<double>(value));
+      gtk_label_set_text(self->vad_label, fmt::format("{0:.0f}", 100.0F * value).c_str());
+    });
+  }));
+
   gtk_label_set_text(self->plugin_credit, ui::get_plugin_credit_translated(self->data->rnnoise->package).c_str());
 
   gsettings_bind_widgets<"input-gain", "output-gain">(self->settings, self->input_gain, self->output_gain);
 
+  ui::gsettings_bind_enum_to_combo_widget(self->settings, "channel-mode", self->channel_mode);
+
+  gsettings_bind_widgets<"enable-vad-gate", "vad-threshold", "vad-hangover">(
+      self->settings, self->enable_vad_gate, self->vad_threshold, self->vad_hangover);
+
   g_settings_bind_with_mapping(
       self->settings, "model-path", self->selection_model, "selected", G_SETTINGS_BIND_DEFAULT,
       +[](GValue* value, GVariant* variant, gpointer user_data) {
@@ -359,6 +389,12 @@ void rnnoise_box_class_init(RNNoiseBoxClass* klass) {
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, toast_overlay);
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, input_gain);
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, output_gain);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, channel_mode);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, enable_vad_gate);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, vad_threshold);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, vad_hangover);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, vad_level);
+  gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, vad_label);
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, input_level_left);
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, input_level_right);
   gtk_widget_class_bind_template_child(widget_class, RNNoiseBox, output_level_left);
@@ -390,6 +426,9 @@ void rnnoise_box_init(RNNoiseBox* self) {
 
   prepare_scales<"dB">(self->input_gain, self->output_gain);
 
+  prepare_spinbuttons<"%">(self->vad_threshold);
+  prepare_spinbuttons<"ms">(self->vad_hangover);
+
   // model dir
 
   if (!std::filesystem::is_directory(model_dir)) {
@@ -0,0 +1,270 @@
+/*
+ *  Copyright © 2017-2023 Wellington Wallace
+ *
+ *  This file is part of Easy Effects.
+ *
+ *  Easy Effects is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Easy Effects is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Easy Effects. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+/*
+  target_clones relies on ifunc. So the runtime dispatch is only enabled where glibc provides it. Everywhere else the
+  functions are compiled once for the baseline of the target architecture.
+*/
+
+#if defined(__x86_64__) && defined(__GLIBC__)
+#define SIMD_RUNTIME_DISPATCH 1
+#define SIMD_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
+#ifdef __clang__
+#define SIMD_SHUFFLE(a, b, i0, i1, i2, i3) __builtin_shufflevector(a, b, i0, i1, i2, i3)
+#else
+#define SIMD_SHUFFLE(a, b, i0, i1, i2, i3) __builtin_shuffle(a, b, v4i{i0, i1, i2, i3})
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+// The helpers below are always inlined. So the warning about passing wide vectors by value does not apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace {
+
+// 16 floats fill one AVX-512 register. With AVX2 and SSE2 the compiler splits them in 2 or 4 registers.
+
+using vf = float __attribute__((vector_size(64)));
+using vi = int32_t __attribute__((vector_size(64)));
+using vs = int16_t __attribute__((vector_size(32)));
+
+using v4f = float __attribute__((vector_size(16)));
+using v4i = int32_t __attribute__((vector_size(16)));
+
+constexpr size_t width = sizeof(vf) / sizeof(float);
+
+constexpr float int16_scale = 32768.0F;
+
+template <typename V, typename T>
+inline auto load(const T* p) -> V {
+  V v;
+
+  std::memcpy(&v, p, sizeof(V));
+
+  return v;
+}
+
+template <typename V, typename T>
+inline void store(T* p, const V& v) {
+  std::memcpy(p, &v, sizeof(V));
+}
+
+inline auto splat(const float& value) -> vf {
+  return vf{} + value;
+}
+
+inline auto horizontal_max(const vf& v) -> float {
+  float m = v[0];
+
+  for (size_t n = 1U; n < width; n++) {
+    m = std::max(m, v[n]);
+  }
+
+  return m;
+}
+
+}  // namespace
+
+namespace simd {
+
+auto instruction_set() -> std::string {
+#ifdef SIMD_RUNTIME_DISPATCH
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f") != 0) {
+    return "AVX-512";
+  }
+
+  if (__builtin_cpu_supports("avx2") != 0) {
+    return "AVX2";
+  }
+
+  return "SSE2";
+#elif defined(__ARM_NEON)
+  return "NEON";
+#else
+  return "generic";
+#endif
+}
+
+SIMD_CLONES void scale(std::span<float> data, const float& gain) {
+  const auto g = splat(gain);
+
+  size_t n = 0U;
+
+  for (; n + width <= data.size(); n += width) {
+    store(data.data() + n, load<vf>(data.data() + n) * g);
+  }
+
+  for (; n < data.size(); n++) {
+    data[n] *= gain;
+  }
+}
+
+SIMD_CLONES auto max(std::span<const float> data) -> float {
+  auto m = splat(std::numeric_limits<float>::lowest());
+
+  size_t n = 0U;
+
+  for (; n + width <= data.size(); n += width) {
+    const auto v = load<vf>(data.data() + n);
+
+    m = (v > m) ? v : m;
+  }
+
+  auto result = horizontal_max(m);
+
+  for (; n < data.size(); n++) {
+    result = std::max(result, data[n]);
+  }
+
+  return result;
+}
+
+SIMD_CLONES void mix(std::span<const float> a, std::span<const float> b, const float& gain, std::span<float> output) {
+  const auto g = splat(gain);
+
+  size_t n = 0U;
+
+  for (; n + width <= a.size(); n += width) {
+    store(output.data() + n, g * (load<vf>(a.data() + n) + load<vf>(b.data() + n)));
+  }
+
+  for (; n < a.size(); n++) {
+    output[n] = gain * (a[n] + b[n]);
+  }
+}
+
+SIMD_CLONES void multiply(std::span<const float> a, std::span<const float> b, std::span<float> output) {
+  size_t n = 0U;
+
+  for (; n + width <= a.size(); n += width) {
+    store(output.data() + n, load<vf>(a.data() + n) * load<vf>(b.data() + n));
+  }
+
+  for (; n < a.size(); n++) {
+    output[n] = a[n] * b[n];
+  }
+}
+
+SIMD_CLONES void interleave(std::span<const float> left, std::span<const float> right, std::span<float> output) {
+  size_t n = 0U;
+
+  for (; n + 4U <= left.size(); n += 4U) {
+    const auto l = load<v4f>(left.data() + n);
+    const auto r = load<v4f>(right.data() + n);
+
+    store(output.data() + 2U * n, SIMD_SHUFFLE(l, r, 0, 4, 1, 5));
+    store(output.data() + 2U * n + 4U, SIMD_SHUFFLE(l, r, 2, 6, 3, 7));
+  }
+
+  for (; n < left.size(); n++) {
+    output[2U * n] = left[n];
+    output[2U * n + 1U] = right[n];
+  }
+}
+
+SIMD_CLONES void deinterleave(std::span<const float> input, std::span<float> left, std::span<float> right) {
+  size_t n = 0U;
+
+  for (; n + 4U <= left.size(); n += 4U) {
+    const auto a = load<v4f>(input.data() + 2U * n);
+    const auto b = load<v4f>(input.data() + 2U * n + 4U);
+
+    store(left.data() + n, SIMD_SHUFFLE(a, b, 0, 2, 4, 6));
+    store(right.data() + n, SIMD_SHUFFLE(a, b, 1, 3, 5, 7));
+  }
+
+  for (; n < left.size(); n++) {
+    left[n] = input[2U * n];
+    right[n] = input[2U * n + 1U];
+  }
+}
+
+SIMD_CLONES void window_and_interleave(std::span<const float> left,
+                                       std::span<const float> right,
+                                       std::span<const float> window,
+                                       std::span<float> output) {
+  size_t n = 0U;
+
+  for (; n + 4U <= left.size(); n += 4U) {
+    const auto w = load<v4f>(window.data() + n);
+
+    const auto l = load<v4f>(left.data() + n) * w;
+    const auto r = load<v4f>(right.data() + n) * w;
+
+    store(output.data() + 2U * n, SIMD_SHUFFLE(l, r, 0, 4, 1, 5));
+    store(output.data() + 2U * n + 4U, SIMD_SHUFFLE(l, r, 2, 6, 3, 7));
+  }
+
+  for (; n < left.size(); n++) {
+    output[2U * n] = left[n] * window[n];
+    output[2U * n + 1U] = right[n] * window[n];
+  }
+}
+
+SIMD_CLONES void float_to_int16(std::span<const float> input, std::span<int16_t> output) {
+  constexpr float lowest = std::numeric_limits<int16_t>::min();
+  constexpr float highest = std::numeric_limits<int16_t>::max();
+
+  const auto s = splat(int16_scale);
+  const auto lo = splat(lowest);
+  const auto hi = splat(highest);
+
+  size_t n = 0U;
+
+  for (; n + width <= input.size(); n += width) {
+    auto v = load<vf>(input.data() + n) * s;
+
+    v = (v < lo) ? lo : v;
+    v = (v > hi) ? hi : v;
+
+    store(output.data() + n, __builtin_convertvector(__builtin_convertvector(v, vi), vs));
+  }
+
+  for (; n < input.size(); n++) {
+    output[n] = static_cast<int16_t>(std::clamp(input[n] * int16_scale, lowest, highest));
+  }
+}
+
+SIMD_CLONES void int16_to_float(std::span<const int16_t> input, std::span<float> output) {
+  const auto s = splat(1.0F / int16_scale);
+
+  size_t n = 0U;
+
+  for (; n + width <= input.size(); n += width) {
+    store(output.data() + n, __builtin_convertvector(load<vs>(input.data() + n), vf) * s);
+  }
+
+  for (; n < input.size(); n++) {
+    output[n] = static_cast<float>(input[n]) / int16_scale;
+  }
+}
+
+}  // namespace simd
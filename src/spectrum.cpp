@@ -23,22 +23,57 @@ Spectrum::Spectrum(const std::string& tag,
                    const std::string& schema,
                    const std::string& schema_path,
                    PipeManager* pipe_manager)
-    : PluginBase(tag, "spectrum", tags::plugin_package::ee, schema, schema_path, pipe_manager), fftw_ready(true) {
-  real_input.resize(n_bands);
-  output.resize(n_bands / 2U + 1U);
+    : PluginBase(tag, "spectrum", tags::plugin_package::ee, schema, schema_path, pipe_manager) {
+  ring_buffer_L.resize(ring_size);
+  ring_buffer_R.resize(ring_size);
 
-  complex_output = fftwf_alloc_complex(n_bands);
+  std::ranges::fill(ring_buffer_L, 0.0F);
+  std::ranges::fill(ring_buffer_R, 0.0F);
 
-  plan = fftwf_plan_dft_r2c_1d(static_cast<int>(n_bands), real_input.data(), complex_output, FFTW_ESTIMATE);
+  mode = parse_mode_key(util::gsettings_get_string(settings, "mode"));
+
+  init_fftw(1024U << static_cast<uint>(g_settings_get_enum(settings, "fft-size")));
+
+  set_overlap(g_settings_get_int(settings, "overlap"));
 
   g_signal_connect(settings, "changed::show", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
                      auto* self = static_cast<Spectrum*>(user_data);
 
-                     std::scoped_lock<std::mutex> lock(self->data_mutex);
-
-                     self->bypass = g_settings_get_boolean(settings, key) == 0;
+                     self->set_bypass(g_settings_get_boolean(settings, key) == 0);
                    }),
                    this);
+
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::fft-size", G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+        auto* self = static_cast<Spectrum*>(user_data);
+
+        std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+        self->init_fftw(1024U << static_cast<uint>(g_settings_get_enum(settings, key)));
+      }),
+      this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::overlap",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<Spectrum*>(user_data);
+
+                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+                                            self->set_overlap(g_settings_get_int(settings, key));
+                                          }),
+                                          this));
+
+  gconnections.push_back(g_signal_connect(settings, "changed::mode",
+                                          G_CALLBACK(+[](GSettings* settings, char* key, gpointer user_data) {
+                                            auto* self = static_cast<Spectrum*>(user_data);
+
+                                            std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+                                            self->set_mode(parse_mode_key(util::gsettings_get_string(settings, key)));
+                                          }),
+                                          this));
+
+  worker = std::thread([this]() { worker_loop(); });
 }
 
 Spectrum::~Spectrum() {
@@ -46,10 +81,24 @@ Spectrum::~Spectrum() {
     disconnect_from_pw();
   }
 
+  data_mutex.lock();
+
+  worker_quit = true;
+
+  data_mutex.unlock();
+
+  worker_cv.notify_one();
+
+  worker.join();
+
   std::scoped_lock<std::mutex> lock(data_mutex);
 
   fftw_ready = false;
 
+  if (complex_input != nullptr) {
+    fftwf_free(complex_input);
+  }
+
   if (complex_output != nullptr) {
     fftwf_free(complex_output);
   }
@@ -59,79 +108,263 @@ Spectrum::~Spectrum() {
   util::debug(log_tag + name + " destroyed");
 }
 
-void Spectrum::setup() {
-  deque_in_mono.resize(0U);
+void Spectrum::init_fftw(const uint& size) {
+  /*
+    fftw planning is not thread safe. So this method is only called from the main thread like every other place
+    where we create fftw plans. Only fftwf_execute is called from the worker thread.
+  */
+
+  fftw_ready = false;
+
+  if (plan != nullptr) {
+    fftwf_destroy_plan(plan);
+
+    plan = nullptr;
+  }
 
-  std::ranges::fill(real_input, 0.0F);
+  if (complex_input != nullptr) {
+    fftwf_free(complex_input);
+
+    complex_input = nullptr;
+  }
+
+  if (complex_output != nullptr) {
+    fftwf_free(complex_output);
+
+    complex_output = nullptr;
+  }
+
+  fft_size = std::clamp(size, 1024U, max_fft_size);
+
+  window.resize(fft_size);
+
+  set_mode(mode);
+
+  // https://en.wikipedia.org/wiki/Hann_function
+
+  for (uint n = 0U; n < fft_size; n++) {
+    window[n] = 0.5F * (1.0F - std::cos(2.0F * std::numbers::pi_v<float> * static_cast<float>(n) /
+                                        static_cast<float>(fft_size - 1U)));
+  }
 
   /*
-    real_input size is hardcoded to 8192. THe same maxium buffer size hardcoded in PipeWire
-    https://gitlab.freedesktop.org/pipewire/pipewire/-/blob/master/src/pipewire/filter.c#L48. If we reevei a smaller
-    array we have to insert some zeros in the beginning.
+    The left channel goes in the real part of the input and the right channel in the imaginary part. This way a single
+    complex fft gives the spectrum of both channels. See calculate_spectrum.
   */
 
-  if (n_samples < real_input.size()) {
-    while (deque_in_mono.size() != real_input.size() - n_samples) {
-      deque_in_mono.push_back(0.0F);
-    }
+  complex_input = fftwf_alloc_complex(fft_size);
+  complex_output = fftwf_alloc_complex(fft_size);
+
+  std::fill_n(&complex_input[0][0], 2U * fft_size, 0.0F);
+
+  plan = fftwf_plan_dft_1d(static_cast<int>(fft_size), complex_input, complex_output, FFTW_FORWARD, FFTW_ESTIMATE);
+
+  fftw_ready = plan != nullptr && complex_input != nullptr && complex_output != nullptr;
+
+  util::debug(log_tag + name + " fft size: " + util::to_string(fft_size));
+}
+
+void Spectrum::set_overlap(const int& percentage) {
+  overlap = 0.01F * static_cast<float>(std::clamp(percentage, 0, 90));
+}
+
+void Spectrum::set_mode(const Mode& value) {
+  mode = value;
+
+  switch (mode) {
+    case Mode::mono:
+      output.resize(1U);
+      break;
+    case Mode::left_right:
+    case Mode::mid_side:
+      output.resize(2U);
+      break;
+    case Mode::all:
+      output.resize(4U);
+      break;
+  }
+
+  for (auto& trace : output) {
+    trace.resize(fft_size / 2U + 1U);
+
+    std::ranges::fill(trace, 0.0);
+  }
+}
+
+auto Spectrum::parse_mode_key(const std::string& key) -> Mode {
+  if (key == "Left/Right") {
+    return Mode::left_right;
+  }
+
+  if (key == "Mid/Side") {
+    return Mode::mid_side;
   }
+
+  if (key == "All") {
+    return Mode::all;
+  }
+
+  return Mode::mono;
 }
 
 void Spectrum::process(std::span<float>& left_in,
                        std::span<float>& right_in,
                        std::span<float>& left_out,
                        std::span<float>& right_out) {
-  std::scoped_lock<std::mutex> lock(data_mutex);
-
   std::copy(left_in.begin(), left_in.end(), left_out.begin());
   std::copy(right_in.begin(), right_in.end(), right_out.begin());
 
-  if (bypass || !fftw_ready) {
+  if (bypass) {
     return;
   }
 
-  for (uint n = 0U; n < left_in.size(); n++) {
-    deque_in_mono.push_back(0.5F * (left_in[n] + right_in[n]));
-  }
+  /*
+    The audio thread never waits for the worker. It just copies the input to the ring buffers and publishes the new
+    write position. Everything else is done by the worker at the rate the ui consumes the spectrum.
+  */
+
+  const auto position = ring_position.load(std::memory_order_relaxed);
+
+  const auto offset = static_cast<size_t>(position % ring_size);
 
-  for (size_t n = 0; n < deque_in_mono.size(); n++) {
-    if (n < real_input.size()) {
-      // https :  // en.wikipedia.org/wiki/Hann_function
+  const auto count = std::min(left_in.size(), ring_size - offset);
 
-      const float w = 0.5F * (1.0F - std::cos(2.0F * std::numbers::pi_v<float> * static_cast<float>(n) /
-                                              static_cast<float>(real_input.size() - 1U)));
+  std::copy(left_in.begin(), left_in.begin() + count, ring_buffer_L.begin() + offset);
+  std::copy(right_in.begin(), right_in.begin() + count, ring_buffer_R.begin() + offset);
 
-      real_input[n] = deque_in_mono[n] * w;
+  std::copy(left_in.begin() + count, left_in.end(), ring_buffer_L.begin());
+  std::copy(right_in.begin() + count, right_in.end(), ring_buffer_R.begin());
+
+  ring_position.store(position + left_in.size(), std::memory_order_release);
+}
+
+void Spectrum::worker_loop() {
+  std::unique_lock<std::mutex> lock(data_mutex);
+
+  while (!worker_quit) {
+    const auto interval = std::chrono::microseconds(static_cast<int64_t>(1000000.0F * notification_time_window));
+
+    worker_cv.wait_for(lock, interval, [this]() { return worker_quit; });
+
+    if (worker_quit) {
+      break;
     }
+
+    if (bypass || !fftw_ready || rate == 0U) {
+      continue;
+    }
+
+    calculate_spectrum();
   }
+}
 
-  size_t count = 0U;
+void Spectrum::calculate_spectrum() {
+  const auto position = ring_position.load(std::memory_order_acquire);
+
+  /*
+    A new frame is analyzed only after at least (1 - overlap) * fft_size new samples arrived. When nothing is being
+    played the worker wakes up but does not calculate anything.
+  */
 
-  while (count < n_samples && !deque_in_mono.empty()) {
-    deque_in_mono.pop_front();
+  const auto hop = static_cast<uint64_t>(std::max(1.0F, (1.0F - overlap) * static_cast<float>(fft_size)));
 
-    count++;
+  if (position - last_fft_position < hop) {
+    return;
   }
 
-  fftwf_execute(plan);
+  last_fft_position = position;
+
+  // the most recent fft_size samples. If we still do not have them the frame is zero padded at the beginning.
+
+  // fftwf_complex is a float[2]. So the fft input is the windowed left and right signals interleaved.
+
+  const std::span frame(reinterpret_cast<float*>(complex_input), 2U * static_cast<size_t>(fft_size));
+
+  const auto n_padding = (position < fft_size) ? static_cast<uint>(fft_size - position) : 0U;
+
+  std::fill(frame.begin(), frame.begin() + 2U * n_padding, 0.0F);
 
-  for (uint i = 0U; i < output.size(); i++) {
-    float sqr = complex_output[i][0] * complex_output[i][0] + complex_output[i][1] * complex_output[i][1];
+  for (uint n = n_padding; n < fft_size;) {
+    const auto idx = static_cast<uint>((position + n - fft_size) % ring_size);
 
-    sqr /= static_cast<float>(output.size() * output.size());
+    // the frame may wrap around the end of the ring. Each contiguous part is copied at once.
 
-    output[i] = static_cast<double>(sqr);
+    const auto count = std::min(fft_size - n, ring_size - idx);
+
+    simd::window_and_interleave(std::span(ring_buffer_L).subspan(idx, count),
+                                std::span(ring_buffer_R).subspan(idx, count), std::span(window).subspan(n, count),
+                                frame.subspan(2U * n, 2U * count));
+
+    n += count;
+  }
+
+  // if the audio thread overwrote part of the frame while we were copying it we just wait for the next one
+
+  if (ring_position.load(std::memory_order_acquire) - position > ring_size - fft_size) {
+    return;
   }
 
-  if (send_notifications) {
-    util::idle_add([=, this]() {
-      if (bypass) {
-        return;
-      }
+  fftwf_execute(plan);
+
+  /*
+    As both inputs are real their spectra are recovered from the complex output Z through its symmetries
+
+    Left[k] = (Z[k] + conj(Z[N - k])) / 2
+    Right[k] = (Z[k] - conj(Z[N - k])) / 2i
 
-      power.emit(rate, output.size(), output);
-    });
+    Mid and side are linear combinations of them.
+  */
+
+  const uint n_bins = fft_size / 2U + 1U;
+
+  const auto scale = 1.0F / static_cast<float>(n_bins * n_bins);
+
+  auto power_of = [&](const float& re, const float& im) { return static_cast<double>((re * re + im * im) * scale); };
+
+  for (uint k = 0U; k < n_bins; k++) {
+    const auto& z = complex_output[k];
+    const auto& z_mirror = complex_output[(fft_size - k) % fft_size];
+
+    const float left_re = 0.5F * (z[0] + z_mirror[0]);
+    const float left_im = 0.5F * (z[1] - z_mirror[1]);
+
+    const float right_re = 0.5F * (z[1] + z_mirror[1]);
+    const float right_im = -0.5F * (z[0] - z_mirror[0]);
+
+    switch (mode) {
+      case Mode::mono:
+        output[0][k] = power_of(0.5F * (left_re + right_re), 0.5F * (left_im + right_im));
+        break;
+      case Mode::left_right:
+        output[0][k] = power_of(left_re, left_im);
+        output[1][k] = power_of(right_re, right_im);
+        break;
+      case Mode::mid_side:
+        output[0][k] = power_of(0.5F * (left_re + right_re), 0.5F * (left_im + right_im));
+        output[1][k] = power_of(0.5F * (left_re - right_re), 0.5F * (left_im - right_im));
+        break;
+      case Mode::all:
+        output[0][k] = power_of(left_re, left_im);
+        output[1][k] = power_of(right_re, right_im);
+        output[2][k] = power_of(0.5F * (left_re + right_re), 0.5F * (left_im + right_im));
+        output[3][k] = power_of(0.5F * (left_re - right_re), 0.5F * (left_im - right_im));
+        break;
+    }
   }
+
+  util::idle_add([this, current_rate = rate]() {
+    if (bypass) {
+      return;
+    }
+
+    data_mutex.lock();
+
+    ui_output = output;
+
+    data_mutex.unlock();
+
+    power.emit(current_rate, ui_output.front().size(), ui_output);
+  });
 }
 
 auto Spectrum::get_latency_seconds() -> float {
@@ -30,7 +30,28 @@ Speex::Speex(const std::string& tag,
       enable_vad(g_settings_get_boolean(settings, "enable-vad")),
       vad_probability_start(g_settings_get_int(settings, "vad-probability-start")),
       vad_probability_continue(g_settings_get_int(settings, "vad-probability-continue")),
-      enable_dereverb(g_settings_get_boolean(settings, "enable-dereverb")) {
+      enable_dereverb(g_settings_get_boolean(settings, "enable-dereverb")),
+      frame_duration(parse_frame_size_key(util::gsettings_get_string(settings, "frame-size"))),
+      channel_mode(parse_channel_mode_key(util::gsettings_get_string(settings, "channel-mode"))) {
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::frame-size", G_CALLBACK(+[](GSettings* settings, char* key, Speex* self) {
+        std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+        self->frame_duration = parse_frame_size_key(util::gsettings_get_string(settings, key));
+
+        if (self->rate != 0U) {
+          self->init_speex();
+        }
+      }),
+      this));
+
+  gconnections.push_back(g_signal_connect(
+      settings, "changed::channel-mode", G_CALLBACK(+[](GSettings* settings, char* key, Speex* self) {
+        std::scoped_lock<std::mutex> lock(self->data_mutex);
+
+        self->channel_mode = parse_channel_mode_key(util::gsettings_get_string(settings, key));
+      }),
+      this));
 
   gconnections.push_back(g_signal_connect(
       settings, "changed::enable-denoise", G_CALLBACK(+[](GSettings* settings, char* key, Speex* self) {
@@ -144,7 +165,6 @@ Speex::Speex(const std::string& tag,
       }),
       this));
 
-
   setup_input_output_gain();
 }
 
@@ -163,51 +183,67 @@ Speex::~Speex() {
 void Speex::setup() {
   std::scoped_lock<std::mutex> lock(data_mutex);
 
-  latency_n_frames = 0U;
+  init_speex();
+}
 
+void Speex::init_speex() {
   speex_ready = false;
 
-  data_L.resize(n_samples);
-  data_R.resize(n_samples);
-
-  if (state_left != nullptr) {
-    speex_preprocess_state_destroy(state_left);
-  }
+  // The preprocessor states only have to be rebuilt when the frame size changes. A new quantum does not affect them.
 
-  if (state_right != nullptr) {
-    speex_preprocess_state_destroy(state_right);
-  }
+  if (const auto size = rate * frame_duration / 1000U; size != frame_size || state_left == nullptr) {
+    frame_size = size;
 
-  state_left = speex_preprocess_state_init(static_cast<int>(n_samples), static_cast<int>(rate));
-  state_right = speex_preprocess_state_init(static_cast<int>(n_samples), static_cast<int>(rate));
+    free_speex();
 
-  if (state_left != nullptr) {
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_DENOISE, &enable_denoise);
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_NOISE_SUPPRESS, &noise_suppression);
+    state_left = speex_preprocess_state_init(static_cast<int>(frame_size), static_cast<int>(rate));
+    state_right = speex_preprocess_state_init(static_cast<int>(frame_size), static_cast<int>(rate));
 
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_AGC, &enable_agc);
+    configure_state(state_left);
+    configure_state(state_right);
 
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_VAD, &enable_vad);
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_PROB_START, &vad_probability_start);
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_PROB_CONTINUE, &vad_probability_continue);
+    data_L.resize(frame_size);
+    data_R.resize(frame_size);
 
-    speex_preprocess_ctl(state_left, SPEEX_PREPROCESS_SET_DEREVERB, &enable_dereverb);
+    frame_L.resize(frame_size);
+    frame_R.resize(frame_size);
   }
 
-  if (state_right != nullptr) {
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_DENOISE, &enable_denoise);
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_NOISE_SUPPRESS, &noise_suppression);
+  frame_position = 0U;
 
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_AGC, &enable_agc);
+  /*
+    When the quantum is a multiple of the frame every input quantum completes the frames it needs. Otherwise one frame
+    of silence in the ring buffer guarantees that there is always a full quantum to be read.
+  */
 
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_VAD, &enable_vad);
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_PROB_START, &vad_probability_start);
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_PROB_CONTINUE, &vad_probability_continue);
+  latency_n_frames = (n_samples % frame_size == 0U) ? 0U : frame_size;
+
+  ring_L.assign(2U * frame_size + n_samples, 0.0F);
+  ring_R.assign(2U * frame_size + n_samples, 0.0F);
+
+  ring_read = 0U;
+  ring_count = latency_n_frames;
+
+  notify_latency = true;
+
+  speex_ready = state_left != nullptr && state_right != nullptr;
+}
 
-    speex_preprocess_ctl(state_right, SPEEX_PREPROCESS_SET_DEREVERB, &enable_dereverb);
+void Speex::configure_state(SpeexPreprocessState* state) {
+  if (state == nullptr) {
+    return;
   }
 
-  speex_ready = true;
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_DENOISE, &enable_denoise);
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_NOISE_SUPPRESS, &noise_suppression);
+
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_AGC, &enable_agc);
+
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_VAD, &enable_vad);
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_PROB_START, &vad_probability_start);
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_PROB_CONTINUE, &vad_probability_continue);
+
+  speex_preprocess_ctl(state, SPEEX_PREPROCESS_SET_DEREVERB, &enable_dereverb);
 }
 
 void Speex::process(std::span<float>& left_in,
@@ -227,34 +263,56 @@ void Speex::process(std::span<float>& left_in,
     apply_gain(left_in, right_in, input_gain);
   }
 
+  for (size_t n = 0U; n < left_in.size(); n++) {
+    frame_L[frame_position] = left_in[n];
+    frame_R[frame_position] = right_in[n];
 
-  for (size_t i = 0; i < n_samples; i++) {
-    data_L[i] = static_cast<spx_int16_t>(left_in[i] * (SHRT_MAX + 1));
+    if (++frame_position == frame_size) {
+      process_frame();
 
-    data_R[i] = static_cast<spx_int16_t>(right_in[i] * (SHRT_MAX + 1));
-  }
-
-  if (speex_preprocess_run(state_left, data_L.data()) == 1) {
-    for (size_t i = 0; i < n_samples; i++) {
-      left_out[i] = static_cast<float>(data_L[i]) * inv_short_max;
+      frame_position = 0U;
     }
-  } else {
-    std::ranges::fill(left_out, 0.0F);
   }
 
-  if (speex_preprocess_run(state_right, data_R.data()) == 1) {
-    for (size_t i = 0; i < n_samples; i++) {
-      right_out[i] = static_cast<float>(data_R[i]) * inv_short_max;
+  const auto capacity = ring_L.size();
+  const auto n_available = std::min(ring_count, left_out.size());
+
+  for (size_t n = 0U; n < left_out.size(); n++) {
+    if (n < n_available) {
+      left_out[n] = ring_L[ring_read];
+      right_out[n] = ring_R[ring_read];
+
+      ring_read = (ring_read + 1U) % capacity;
+    } else {
+      left_out[n] = 0.0F;
+      right_out[n] = 0.0F;
     }
-  } else {
-    std::ranges::fill(right_out, 0.0F);
   }
 
+  ring_count -= n_available;
 
   if (output_gain != 1.0F) {
     apply_gain(left_out, right_out, output_gain);
   }
 
+  if (notify_latency) {
+    latency_value = static_cast<float>(latency_n_frames) / static_cast<float>(rate);
+
+    util::debug(log_tag + name + " latency: " + util::to_string(latency_value, "") + " s");
+
+    util::idle_add([=, this]() {
+      if (!post_messages || latency.empty()) {
+        return;
+      }
+
+      latency.emit();
+    });
+
+    update_filter_params();
+
+    notify_latency = false;
+  }
+
   if (post_messages) {
     get_peaks(left_in, right_in, left_out, right_out);
 
@@ -264,6 +322,69 @@ void Speex::process(std::span<float>& left_in,
   }
 }
 
+void Speex::process_frame() {
+  // speex_preprocess_run returns 0 when the voice activity detection is enabled and finds no speech
+
+  if (channel_mode == ChannelMode::mono_sum) {
+    simd::mix(frame_L, frame_R, 0.5F, frame_L);
+
+    simd::float_to_int16(frame_L, data_L);
+
+    if (speex_preprocess_run(state_left, data_L.data()) == 1) {
+      simd::int16_to_float(data_L, frame_L);
+    } else {
+      std::ranges::fill(frame_L, 0.0F);
+    }
+
+    std::ranges::copy(frame_L, frame_R.begin());
+  } else {
+    simd::float_to_int16(frame_L, data_L);
+    simd::float_to_int16(frame_R, data_R);
+
+    if (speex_preprocess_run(state_left, data_L.data()) == 1) {
+      simd::int16_to_float(data_L, frame_L);
+    } else {
+      std::ranges::fill(frame_L, 0.0F);
+    }
+
+    if (speex_preprocess_run(state_right, data_R.data()) == 1) {
+      simd::int16_to_float(data_R, frame_R);
+    } else {
+      std::ranges::fill(frame_R, 0.0F);
+    }
+  }
+
+  const auto capacity = ring_L.size();
+
+  if (ring_count + frame_size > capacity) {
+    return;
+  }
+
+  for (size_t n = 0U, write = (ring_read + ring_count) % capacity; n < frame_size; n++) {
+    ring_L[write] = frame_L[n];
+    ring_R[write] = frame_R[n];
+
+    write = (write + 1U) % capacity;
+  }
+
+  ring_count += frame_size;
+}
+
+auto Speex::parse_channel_mode_key(const std::string& key) -> ChannelMode {
+  if (key == "Mono Sum") {
+    return ChannelMode::mono_sum;
+  }
+
+  return ChannelMode::independent;
+}
+
+auto Speex::parse_frame_size_key(const std::string& key) -> uint {
+  if (key == "10 ms") {
+    return 10U;
+  }
+
+  return 20U;
+}
 
 void Speex::free_speex() {
   if (state_left != nullptr) {
@@ -278,7 +399,6 @@ void Speex::free_speex() {
   state_right = nullptr;
 }
 
-
 auto Speex::get_latency_seconds() -> float {
   return latency_value;
 }
@@ -54,6 +54,8 @@ struct _SpeexBox {
 
   GtkSpinButton *noise_suppression, *vad_probability_start, *vad_probability_continue;
 
+  AdwComboRow *frame_size, *channel_mode;
+
   GSettings* settings;
 
   Data* data;
@@ -114,6 +116,9 @@ void setup(SpeexBox* self,
       self->settings, self->input_gain, self->output_gain, self->enable_denoise, self->noise_suppression,
       self->enable_agc, self->enable_vad, self->vad_probability_start, self->vad_probability_continue,
       self->enable_dereverb);
+
+  ui::gsettings_bind_enum_to_combo_widget(self->settings, "frame-size", self->frame_size);
+  ui::gsettings_bind_enum_to_combo_widget(self->settings, "channel-mode", self->channel_mode);
 }
 
 void dispose(GObject* object) {
@@ -180,6 +185,8 @@ void speex_box_class_init(SpeexBoxClass* klass) {
   gtk_widget_class_bind_template_child(widget_class, SpeexBox, noise_suppression);
   gtk_widget_class_bind_template_child(widget_class, SpeexBox, vad_probability_start);
   gtk_widget_class_bind_template_child(widget_class, SpeexBox, vad_probability_continue);
+  gtk_widget_class_bind_template_child(widget_class, SpeexBox, frame_size);
+  gtk_widget_class_bind_template_child(widget_class, SpeexBox, channel_mode);
 
   gtk_widget_class_bind_template_callback(widget_class, on_reset);
 }
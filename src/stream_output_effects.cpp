@@ -302,9 +302,6 @@ void StreamOutputEffects::connect_filters(const bool& bypass) {
 void StreamOutputEffects::disconnect_filters() {
   std::set<uint> link_id_list;
 
-  const auto selected_plugins_list =
-      (bypass) ? std::vector<std::string>() : util::gchar_array_to_vector(g_settings_get_strv(settings, "plugins"));
-
   for (const auto& plugin : plugins | std::views::values) {
     for (const auto& link : pm->list_links) {
       if (link.input_node_id == plugin->get_node_id() || link.output_node_id == plugin->get_node_id()) {
@@ -312,12 +309,15 @@ void StreamOutputEffects::disconnect_filters() {
       }
     }
 
-    if (plugin->connected_to_pw) {
-      if (std::ranges::find(selected_plugins_list, plugin->name) == selected_plugins_list.end()) {
-        util::debug("disconnecting the " + plugin->name + " filter from PipeWire");
+    /*
+      The plugins in the chain stay connected while it is relinked. The ones removed from it are left to
+      remove_unused_filters.
+    */
 
-        plugin->disconnect_from_pw();
-      }
+    if (bypass && plugin->connected_to_pw) {
+      util::debug("disconnecting the " + plugin->name + " filter from PipeWire");
+
+      plugin->disconnect_from_pw();
     }
   }
 
@@ -336,7 +336,7 @@ void StreamOutputEffects::disconnect_filters() {
 
   list_proxies.clear();
 
-  // remove_unused_filters();
+  remove_unused_filters();
 }
 
 void StreamOutputEffects::set_bypass(const bool& state) {
@@ -46,6 +46,7 @@ auto get_translated() -> std::map<std::string, std::string> {
                                                    {level_meter, _("Level Meter")},
                                                    {limiter, _("Limiter")},
                                                    {loudness, _("Loudness")},
+                                                   {lv2_plugin, _("LV2 Plugin")},
                                                    {maximizer, _("Maximizer")},
                                                    {multiband_compressor, _("Multiband Compressor")},
                                                    {multiband_gate, _("Multiband Gate")},
@@ -131,6 +132,10 @@ auto get_base_name(std::string_view name) -> std::string {
     return tags::plugin_name::loudness;
   }
 
+  if (name.starts_with(tags::plugin_name::lv2_plugin)) {
+    return tags::plugin_name::lv2_plugin;
+  }
+
   if (name.starts_with(tags::plugin_name::maximizer)) {
     return tags::plugin_name::maximizer;
   }